@@ -0,0 +1,455 @@
+#ifndef GEO_ALLOCATOR_H
+#define GEO_ALLOCATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace geo
+{
+	struct AllocationStats
+	{
+		// trips to the heap, and the bytes they are holding on to
+		std::size_t allocations;
+		std::size_t bytes;
+
+		// handed out since construction, and currently handed out (objects for pools, bytes for arenas)
+		std::size_t requests;
+		std::size_t live;
+	};
+
+	// fixed-size objects carved out of blocks of BLOCK_SIZE. released objects go on a free list and are
+	// handed out again as they are, so any capacity they grew while in use is reused along with them
+	template<typename T, std::size_t BLOCK_SIZE = 64>
+	class Pool
+	{
+	private:
+		std::vector<std::unique_ptr<T[]>> _blocks;
+		std::vector<T*> _free;
+		std::size_t _requests;
+
+	public:
+		T* acquire()
+		{
+			if (_free.empty())
+			{
+				auto& block = _blocks.emplace_back(std::make_unique<T[]>(BLOCK_SIZE));
+				_free.reserve(capacity());
+
+				// reversed so objects are handed out in address order
+				for (auto i = BLOCK_SIZE; i-- > 0;)
+				{
+					_free.emplace_back(&block[i]);
+				}
+			}
+
+			const auto object = _free.back();
+			_free.pop_back();
+
+			_requests++;
+			return object;
+		}
+
+		void release(T* object)
+		{
+			_free.emplace_back(object);
+		}
+
+	public:
+		std::size_t capacity() const
+		{
+			return _blocks.size() * BLOCK_SIZE;
+		}
+
+		std::size_t available() const
+		{
+			return _free.size();
+		}
+
+		AllocationStats stats() const
+		{
+			return { _blocks.size(), capacity() * sizeof(T), _requests, capacity() - available() };
+		}
+
+	public:
+		Pool()
+			: _requests{ 0 }
+		{
+		}
+
+		Pool(const Pool&) = delete;
+		Pool& operator=(const Pool&) = delete;
+	};
+
+	// a pool that may be used from several threads at once
+	template<typename T, std::size_t BLOCK_SIZE = 64>
+	class SharedPool
+	{
+	private:
+		mutable std::mutex _mutex;
+		Pool<T, BLOCK_SIZE> _pool;
+
+	public:
+		T* acquire()
+		{
+			std::scoped_lock lock{ _mutex };
+			return _pool.acquire();
+		}
+
+		void release(T* object)
+		{
+			std::scoped_lock lock{ _mutex };
+			_pool.release(object);
+		}
+
+		AllocationStats stats() const
+		{
+			std::scoped_lock lock{ _mutex };
+			return _pool.stats();
+		}
+	};
+
+	// bump allocator for transient data. allocations are carved from the current block and never freed
+	// one by one; reset() and Scope rewind in O(1) without running destructors, so only trivially
+	// destructible types belong here. blocks are kept, so a warmed-up arena stops touching the heap
+	class Arena
+	{
+	private:
+		struct Block
+		{
+			std::unique_ptr<std::byte[]> memory;
+			std::size_t size;
+		};
+
+	private:
+		std::vector<Block> _blocks;
+		std::size_t _block;
+		std::size_t _offset;
+		std::size_t _block_size;
+
+	private:
+		std::size_t _bytes;
+		std::size_t _requests;
+
+	public:
+		// rewinds the arena to where it was when the scope was opened
+		class Scope
+		{
+		private:
+			Arena& _arena;
+			std::size_t _block;
+			std::size_t _offset;
+
+		public:
+			Scope(Arena& arena)
+				: _arena{ arena }, _block{ arena._block }, _offset{ arena._offset }
+			{
+			}
+
+			~Scope()
+			{
+				_arena._block = _block;
+				_arena._offset = _offset;
+			}
+
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+		};
+
+	public:
+		void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t))
+		{
+			_requests++;
+
+			while (_block < _blocks.size())
+			{
+				auto& block = _blocks[_block];
+
+				const auto address = reinterpret_cast<std::uintptr_t>(block.memory.get()) + _offset;
+				const auto aligned = (address + alignment - 1) & ~(alignment - 1);
+				const auto end = aligned - reinterpret_cast<std::uintptr_t>(block.memory.get()) + size;
+
+				if (end <= block.size)
+				{
+					_offset = end;
+					return reinterpret_cast<void*>(aligned);
+				}
+
+				_block++;
+				_offset = 0;
+			}
+
+			// out of blocks: add one big enough for this request, even if it is larger than usual
+			const auto bytes = std::max(_block_size, size + alignment);
+
+			_blocks.emplace_back(Block{ std::make_unique<std::byte[]>(bytes), bytes });
+			_bytes += bytes;
+
+			_requests--;
+			return allocate(size, alignment);
+		}
+
+		// uninitialized storage for count objects of T
+		template<typename T>
+		std::span<T> allocate(std::size_t count)
+		{
+			static_assert(std::is_trivially_destructible_v<T>, "arena memory is released without running destructors");
+
+			return { static_cast<T*>(allocate(sizeof(T) * count, alignof(T))), count };
+		}
+
+		void reset()
+		{
+			_block = 0;
+			_offset = 0;
+		}
+
+	public:
+		AllocationStats stats() const
+		{
+			auto live = _offset;
+
+			for (auto i = 0uz; i < std::min(_block, _blocks.size()); i++)
+			{
+				live += _blocks[i].size;
+			}
+
+			return { _blocks.size(), _bytes, _requests, live };
+		}
+
+	public:
+		Arena(std::size_t block_size = 1 << 20)
+			: _block{ 0 }, _offset{ 0 }, _block_size{ block_size }, _bytes{ 0 }, _requests{ 0 }
+		{
+		}
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+	};
+
+	// per-thread arena for scratch that only lives for one call, such as meshing working sets
+	inline Arena& scratch_arena()
+	{
+		thread_local Arena arena{};
+		return arena;
+	}
+
+	// hands out ranges of a linear resource such as a gpu buffer, in whatever unit the caller counts in.
+	// allocation takes the smallest free range that fits and released ranges merge with their free
+	// neighbors. allocations are named by handles rather than offsets, so compact() can slide them
+	// toward the front a few at a time and gather the free space into one range at the end
+	class RangeAllocator
+	{
+	public:
+		using Handle = std::uint32_t;
+
+		static constexpr auto INVALID = ~Handle{ 0 };
+
+		struct Stats
+		{
+			std::size_t capacity;
+			std::size_t used;
+			std::size_t allocations;
+
+			// free ranges, and the size of the largest
+			std::size_t holes;
+			std::size_t largest;
+
+			// the share of free space outside the largest free range; 0 when it is all in one piece
+			float fragmentation() const
+			{
+				const auto free = capacity - used;
+				return (free > 0) ? 1.0f - (static_cast<float>(largest) / static_cast<float>(free)) : 0.0f;
+			}
+		};
+
+	private:
+		struct Range
+		{
+			std::size_t offset;
+			std::size_t size;
+		};
+
+	private:
+		std::size_t _capacity;
+		std::size_t _used;
+
+		// free ranges by offset for merging, and by size then offset for best fit
+		std::map<std::size_t, std::size_t> _free;
+		std::set<std::pair<std::size_t, std::size_t>> _sizes;
+
+		// live allocations by offset, so compaction can find the one after a hole
+		std::map<std::size_t, Handle> _allocated;
+
+		std::vector<Range> _ranges;
+		std::vector<Handle> _handles;
+
+	private:
+		void add_free(std::size_t offset, std::size_t size)
+		{
+			if (const auto next = _free.find(offset + size); next != _free.end())
+			{
+				size += next->second;
+				_sizes.erase({ next->second, next->first });
+				_free.erase(next);
+			}
+
+			if (auto previous = _free.lower_bound(offset); previous != _free.begin())
+			{
+				previous--;
+
+				if (previous->first + previous->second == offset)
+				{
+					offset = previous->first;
+					size += previous->second;
+					_sizes.erase({ previous->second, previous->first });
+					_free.erase(previous);
+				}
+			}
+
+			_free.emplace(offset, size);
+			_sizes.emplace(size, offset);
+		}
+
+	public:
+		// INVALID when no free range is large enough; grow() and try again
+		Handle allocate(const std::size_t size)
+		{
+			const auto fit = _sizes.lower_bound({ size, 0 });
+
+			if (fit == _sizes.end())
+			{
+				return INVALID;
+			}
+
+			const auto [length, offset] = *fit;
+
+			_sizes.erase(fit);
+			_free.erase(offset);
+
+			// both neighbors of the remainder are in use, so there is nothing to merge
+			if (length > size)
+			{
+				_free.emplace(offset + size, length - size);
+				_sizes.emplace(length - size, offset + size);
+			}
+
+			auto handle = INVALID;
+
+			if (_handles.empty())
+			{
+				handle = static_cast<Handle>(_ranges.size());
+				_ranges.emplace_back();
+			}
+
+			else
+			{
+				handle = _handles.back();
+				_handles.pop_back();
+			}
+
+			_ranges[handle] = Range{ offset, size };
+			_allocated.emplace(offset, handle);
+			_used += size;
+
+			return handle;
+		}
+
+		void release(const Handle handle)
+		{
+			const auto range = _ranges[handle];
+
+			_allocated.erase(range.offset);
+			_handles.emplace_back(handle);
+			_used -= range.size;
+
+			add_free(range.offset, range.size);
+		}
+
+		// extends the resource at its end; never shrinks
+		void grow(const std::size_t capacity)
+		{
+			if (capacity > _capacity)
+			{
+				add_free(_capacity, capacity - _capacity);
+				_capacity = capacity;
+			}
+		}
+
+		// slides the allocations after the first hole down into it, one at a time, until about budget units
+		// have moved or the free space is all at the end. move(handle, from, to, size) copies the contents;
+		// to is always below from, but the two may overlap. returns the units moved
+		template<typename Move>
+		std::size_t compact(const std::size_t budget, Move&& move)
+		{
+			auto moved = 0uz;
+
+			while (moved < budget && !_free.empty())
+			{
+				const auto [hole, length] = *_free.begin();
+				const auto next = _allocated.find(hole + length);
+
+				// the first hole runs to the end
+				if (next == _allocated.end())
+				{
+					break;
+				}
+
+				const auto handle = next->second;
+				auto& range = _ranges[handle];
+
+				move(handle, range.offset, hole, range.size);
+				moved += range.size;
+
+				_sizes.erase({ length, hole });
+				_free.erase(_free.begin());
+				_allocated.erase(next);
+
+				range.offset = hole;
+				_allocated.emplace(hole, handle);
+
+				add_free(hole + range.size, length);
+			}
+
+			return moved;
+		}
+
+	public:
+		std::size_t offset(const Handle handle) const
+		{
+			return _ranges[handle].offset;
+		}
+
+		std::size_t size(const Handle handle) const
+		{
+			return _ranges[handle].size;
+		}
+
+		std::size_t capacity() const
+		{
+			return _capacity;
+		}
+
+		Stats stats() const
+		{
+			return { _capacity, _used, _allocated.size(), _free.size(), _sizes.empty() ? 0 : _sizes.rbegin()->first };
+		}
+
+	public:
+		RangeAllocator(const std::size_t capacity = 0)
+			: _capacity{ 0 }, _used{ 0 }
+		{
+			grow(capacity);
+		}
+	};
+}
+
+#endif
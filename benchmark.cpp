@@ -0,0 +1,1152 @@
+// headless stress tests and benchmarks; builds anywhere with a C++23 compiler, e.g.
+// g++ -std=c++23 -O2 -pthread benchmark.cpp -o benchmark
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "glad.h"
+
+#include "mesher.h"
+#include "mesh_cache.h"
+#include "scheduler.h"
+#include "cache.h"
+#include "frustum.h"
+#include "world.h"
+
+// every trip to the heap is counted, so the benchmarks can show where steady states stop allocating.
+// all the replaceable forms are covered, so nothing reaches the library's allocator and gets freed here
+static std::atomic<std::size_t> heap_allocations{ 0 };
+
+static void* allocate(std::size_t size, std::size_t alignment)
+{
+	heap_allocations.fetch_add(1, std::memory_order_relaxed);
+
+	size = (size == 0) ? 1 : size;
+
+	if (alignment <= alignof(std::max_align_t))
+	{
+		return std::malloc(size);
+	}
+
+	// aligned_alloc wants a size that is a multiple of the alignment
+	return std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+}
+
+static void* allocate_or_throw(std::size_t size, std::size_t alignment)
+{
+	if (const auto memory = allocate(size, alignment))
+	{
+		return memory;
+	}
+
+	throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size)
+{
+	return allocate_or_throw(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size)
+{
+	return allocate_or_throw(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	return allocate_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return allocate_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+// malloc and aligned_alloc memory both go back through free
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	std::free(memory);
+}
+
+namespace
+{
+	using clock_type = std::chrono::steady_clock;
+
+	double milliseconds_since(clock_type::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+	}
+
+	void check(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			std::fprintf(stderr, "FAILED: %s\n", what);
+			std::exit(EXIT_FAILURE);
+		}
+	}
+
+	// counts hardware cache misses around a region where the platform allows it (linux perf events);
+	// misses() returns -1 otherwise, so timings are still reported without counters
+	class CacheMisses
+	{
+	private:
+		int _fd;
+
+	public:
+		void start()
+		{
+#ifdef __linux__
+			if (_fd >= 0)
+			{
+				ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+				ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+#endif
+		}
+
+		long long misses()
+		{
+#ifdef __linux__
+			long long count = 0;
+
+			if (_fd >= 0 && ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0) == 0 && read(_fd, &count, sizeof(count)) == sizeof(count))
+			{
+				return count;
+			}
+#endif
+			return -1;
+		}
+
+	public:
+		CacheMisses()
+			: _fd{ -1 }
+		{
+#ifdef __linux__
+			perf_event_attr attributes{};
+			attributes.size = sizeof(attributes);
+			attributes.type = PERF_TYPE_HW_CACHE;
+			attributes.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			attributes.disabled = 1;
+			attributes.exclude_kernel = 1;
+			attributes.exclude_hv = 1;
+
+			_fd = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+		}
+
+		~CacheMisses()
+		{
+#ifdef __linux__
+			if (_fd >= 0)
+			{
+				close(_fd);
+			}
+#endif
+		}
+	};
+
+	std::string describe(long long misses)
+	{
+		return (misses < 0) ? std::string{ "n/a" } : std::to_string(misses);
+	}
+
+	// deliberately fine-grained so the deques and stealing get hammered
+	long fibonacci(geo::Scheduler& scheduler, int n)
+	{
+		if (n < 12)
+		{
+			long a = 0, b = 1;
+
+			for (auto i = 0; i < n; i++)
+			{
+				const auto t = a + b;
+				a = b;
+				b = t;
+			}
+
+			return a;
+		}
+
+		long x = 0;
+		geo::Counter counter{};
+
+		scheduler.run([&]() { x = fibonacci(scheduler, n - 1); }, &counter);
+		const auto y = fibonacci(scheduler, n - 2);
+		scheduler.wait(counter);
+
+		return x + y;
+	}
+
+	void stress_scheduler(geo::Scheduler& scheduler)
+	{
+		for (auto round = 0; round < 20; round++)
+		{
+			check(fibonacci(scheduler, 25) == 75025, "fibonacci");
+
+			std::atomic<long> sum{ 0 };
+			scheduler.parallel_for(100000, 64, [&](std::size_t begin, std::size_t end)
+			{
+				long local = 0;
+
+				for (auto i = begin; i < end; i++)
+				{
+					local += static_cast<long>(i);
+				}
+
+				sum.fetch_add(local, std::memory_order_relaxed);
+			});
+
+			check(sum.load() == 100000l * 99999l / 2, "parallel_for");
+
+			// a chain of stages where each only starts once the previous one finished
+			std::atomic<int> progress{ 0 };
+			std::vector<geo::Counter> stages(8);
+
+			for (auto i = 0; i < 100; i++)
+			{
+				scheduler.run([&]() { progress.fetch_add(1); }, &stages[0]);
+			}
+
+			for (auto stage = 1uz; stage < stages.size(); stage++)
+			{
+				scheduler.run_after(stages[stage - 1], [&, stage]()
+				{
+					check(progress.load() == static_cast<int>(99 + stage), "run_after ordering");
+					progress.fetch_add(1);
+				}, &stages[stage]);
+			}
+
+			scheduler.wait(stages.back());
+			check(progress.load() == 107, "run_after");
+		}
+	}
+
+	std::vector<geo::Subchunk> random_terrain(std::size_t count)
+	{
+		constexpr auto L = geo::Subchunk::CHUNK_LENGTH;
+
+		std::mt19937 random{ 1234 };
+		std::vector<geo::Subchunk> subchunks(count);
+
+		for (auto& subchunk : subchunks)
+		{
+			for (auto x = 0uz; x < L; x++)
+			{
+				for (auto z = 0uz; z < L; z++)
+				{
+					const auto height = random() % L;
+
+					for (auto y = 0uz; y <= height; y++)
+					{
+						subchunk.set(x, y, z, static_cast<geo::BlockId>(1 + (y * 3) / L));
+					}
+				}
+			}
+		}
+
+		return subchunks;
+	}
+
+	void benchmark_meshing(geo::Scheduler& scheduler)
+	{
+		const auto subchunks = random_terrain(512);
+		std::vector<geo::Mesh> meshes(subchunks.size());
+
+		auto start = clock_type::now();
+
+		for (auto i = 0uz; i < subchunks.size(); i++)
+		{
+			geo::build_mesh(subchunks[i], meshes[i], geo::MeshMode::BINARY);
+		}
+
+		const auto serial = milliseconds_since(start);
+
+		std::size_t faces = 0;
+
+		for (const auto& mesh : meshes)
+		{
+			faces += mesh.faces();
+		}
+
+		start = clock_type::now();
+
+		scheduler.parallel_for(subchunks.size(), 8, [&](std::size_t begin, std::size_t end)
+		{
+			for (auto i = begin; i < end; i++)
+			{
+				meshes[i].clear();
+				geo::build_mesh(subchunks[i], meshes[i], geo::MeshMode::BINARY);
+			}
+		});
+
+		const auto parallel = milliseconds_since(start);
+
+		std::size_t parallel_faces = 0;
+
+		for (const auto& mesh : meshes)
+		{
+			parallel_faces += mesh.faces();
+		}
+
+		check(faces == parallel_faces, "parallel meshing");
+
+		std::printf("meshing %zu subchunks: serial %.2f ms, %zu workers %.2f ms (%zu faces)\n",
+			subchunks.size(), serial, scheduler.workers(), parallel, faces);
+	}
+
+	// every unit face a mesh covers as face, block position and id, sorted so meshes built differently compare equal
+	std::vector<std::uint64_t> unit_faces(const geo::Mesh& mesh)
+	{
+		std::vector<std::uint64_t> result{};
+
+		for (auto q = 0uz; q < mesh.vertices.size(); q += 4)
+		{
+			std::array<std::uint32_t, 3> lo{ ~0u, ~0u, ~0u };
+			std::array<std::uint32_t, 3> hi{};
+
+			for (auto v = q; v < q + 4; v++)
+			{
+				const auto& vertex = mesh.vertices[v];
+				const std::array<std::uint32_t, 3> corner{ vertex.x(), vertex.y(), vertex.z() };
+
+				for (auto a = 0; a < 3; a++)
+				{
+					lo[a] = std::min(lo[a], corner[a]);
+					hi[a] = std::max(hi[a], corner[a]);
+				}
+			}
+
+			const auto face = mesh.vertices[q].face();
+			const auto id = mesh.vertices[q].id();
+			const auto a = geo::face_axis[face];
+
+			// the quad is flat along its normal, on the far side of the blocks for positive faces
+			lo[a] -= (geo::face_direction[face] > 0) ? 1 : 0;
+			hi[a] = lo[a] + 1;
+
+			for (auto x = lo[0]; x < hi[0]; x++)
+			{
+				for (auto y = lo[1]; y < hi[1]; y++)
+				{
+					for (auto z = lo[2]; z < hi[2]; z++)
+					{
+						result.emplace_back((static_cast<std::uint64_t>(face) << 40) | (static_cast<std::uint64_t>(x) << 32) |
+							(static_cast<std::uint64_t>(y) << 24) | (static_cast<std::uint64_t>(z) << 16) | id);
+					}
+				}
+			}
+		}
+
+		std::ranges::sort(result);
+		return result;
+	}
+
+	// naive, greedy and binary meshing must cover exactly the same unit faces with the same blocks, whatever
+	// the density of the subchunk and whether its neighbors are missing, uniform or mixed
+	template<std::size_t LENGTH>
+	void check_meshers()
+	{
+		using subchunk_type = geo::BasicSubchunk<LENGTH>;
+
+		constexpr auto L = subchunk_type::CHUNK_LENGTH;
+		constexpr auto SAMPLES = 24;
+
+		std::mt19937 random{ 4321 };
+
+		const auto random_subchunk = [&]()
+		{
+			subchunk_type result{};
+			const auto density = 1 + (random() % 9);
+
+			for (auto x = 0uz; x < L; x++)
+			{
+				for (auto y = 0uz; y < L; y++)
+				{
+					for (auto z = 0uz; z < L; z++)
+					{
+						// banded ids with some noise, so the merging meshers have runs to merge and edges to stop at
+						if (random() % 10 < density)
+						{
+							result.set(x, y, z, static_cast<geo::BlockId>(1 + (((y / 4) + ((random() % 8) == 0)) % 3)));
+						}
+					}
+				}
+			}
+
+			return result;
+		};
+
+		std::vector<subchunk_type> pool{};
+
+		for (auto i = 0; i < 4; i++)
+		{
+			pool.emplace_back(random_subchunk());
+		}
+
+		pool.emplace_back().fill(1);
+		pool.emplace_back();
+
+		auto faces = 0uz;
+
+		for (auto sample = 0; sample < SAMPLES; sample++)
+		{
+			const auto subchunk = random_subchunk();
+
+			geo::BasicNeighbors<subchunk_type> neighbors{};
+
+			for (auto& neighbor : neighbors)
+			{
+				const auto pick = random() % (pool.size() + 1);
+				neighbor = (pick < pool.size()) ? &pool[pick] : nullptr;
+			}
+
+			std::array<std::vector<std::uint64_t>, 3> covered{};
+			const std::array modes{ geo::MeshMode::NAIVE, geo::MeshMode::GREEDY, geo::MeshMode::BINARY };
+
+			for (auto m = 0uz; m < modes.size(); m++)
+			{
+				geo::Mesh mesh{};
+				geo::build_mesh(subchunk, mesh, modes[m], neighbors);
+				covered[m] = unit_faces(mesh);
+			}
+
+			check(covered[0].size() == geo::count_faces(subchunk, neighbors), "naive mesher face count");
+			check(covered[1] == covered[0], "greedy mesher matches naive");
+			check(covered[2] == covered[0], "binary mesher matches naive");
+
+			faces += covered[0].size();
+		}
+
+		std::printf("meshers agree on %d random %d^3 subchunks (%zu unit faces)\n", SAMPLES, L, faces);
+	}
+
+	// face culling alone: every subchunk against a full set of neighbors, straight from the occupancy masks
+	void benchmark_culling()
+	{
+		const auto subchunks = random_terrain(512);
+
+		auto faces = 0uz;
+		const auto start = clock_type::now();
+
+		for (auto i = 0uz; i < subchunks.size(); i++)
+		{
+			geo::Neighbors neighbors{};
+
+			for (auto f = 0uz; f < neighbors.size(); f++)
+			{
+				neighbors[f] = &subchunks[(i + f + 1) % subchunks.size()];
+			}
+
+			faces += geo::count_faces(subchunks[i], neighbors);
+		}
+
+		std::printf("culling %zu subchunks: %.2f ms (%zu visible faces)\n", subchunks.size(), milliseconds_since(start), faces);
+	}
+
+	// gathers the six neighbors of every voxel, then takes random unit-step walks the way a ray or a
+	// light flood would, over enough subchunks that they don't all fit in cache
+	template<template<std::size_t> typename Layout>
+	void benchmark_layout(const char* name)
+	{
+		using subchunk_type = geo::BasicSubchunk<16, Layout>;
+
+		constexpr auto L = static_cast<int>(subchunk_type::CHUNK_LENGTH);
+		constexpr auto COUNT = 256uz;
+
+		std::mt19937 random{ 99 };
+		std::vector<subchunk_type> subchunks(COUNT);
+
+		for (auto& subchunk : subchunks)
+		{
+			for (auto x = 0; x < L; x++)
+			{
+				for (auto y = 0; y < L; y++)
+				{
+					for (auto z = 0; z < L; z++)
+					{
+						subchunk.set(x, y, z, static_cast<geo::BlockId>(random() % geo::registry().size()));
+					}
+				}
+			}
+		}
+
+		CacheMisses counter{};
+
+		const auto read = [&](const subchunk_type& subchunk, int x, int y, int z) -> unsigned
+		{
+			return subchunk.get(static_cast<std::size_t>(x) % L, static_cast<std::size_t>(y) % L, static_cast<std::size_t>(z) % L);
+		};
+
+		auto checksum = 0u;
+
+		counter.start();
+		auto start = clock_type::now();
+
+		for (const auto& subchunk : subchunks)
+		{
+			for (auto x = 0; x < L; x++)
+			{
+				for (auto y = 0; y < L; y++)
+				{
+					for (auto z = 0; z < L; z++)
+					{
+						checksum += read(subchunk, x - 1, y, z) + read(subchunk, x + 1, y, z) +
+									read(subchunk, x, y - 1, z) + read(subchunk, x, y + 1, z) +
+									read(subchunk, x, y, z - 1) + read(subchunk, x, y, z + 1);
+					}
+				}
+			}
+		}
+
+		const auto gather = milliseconds_since(start);
+		const auto gather_misses = counter.misses();
+
+		constexpr auto WALKS = 20000;
+		constexpr auto STEPS = 256;
+
+		std::vector<std::uint32_t> choices(WALKS * STEPS);
+
+		for (auto& choice : choices)
+		{
+			choice = static_cast<std::uint32_t>(random());
+		}
+
+		counter.start();
+		start = clock_type::now();
+
+		for (auto walk = 0; walk < WALKS; walk++)
+		{
+			const auto& subchunk = subchunks[walk % COUNT];
+			std::array<int, 3> p{ L / 2, L / 2, L / 2 };
+
+			for (auto step = 0; step < STEPS; step++)
+			{
+				const auto choice = choices[(walk * STEPS) + step];
+				p[choice % 3] += (choice & 8) ? 1 : -1;
+				checksum += read(subchunk, p[0], p[1], p[2]);
+			}
+		}
+
+		const auto walk = milliseconds_since(start);
+		const auto walk_misses = counter.misses();
+
+		std::printf("%-7s layout: neighbor gather %.2f ms (%s L1d misses), random walks %.2f ms (%s L1d misses) [%u]\n",
+			name, gather, describe(gather_misses).c_str(), walk, describe(walk_misses).c_str(), checksum);
+	}
+
+	int terrain_height(int x, int z, int base)
+	{
+		return base + static_cast<int>(6.0 * std::sin(x * 0.1) + 6.0 * std::cos(z * 0.13));
+	}
+
+	// stone, then a few layers of dirt under a grass top
+	geo::BlockId terrain_type(int y, int height)
+	{
+		return static_cast<geo::BlockId>((y < height - 3) ? 1 : (y < height) ? 2 : 3);
+	}
+
+	// fills a column with terrain_height() around y = 100
+	void generate_column(geo::Chunk& chunk, const geo::ChunkCoord& coord)
+	{
+		constexpr auto L = geo::Subchunk::CHUNK_LENGTH;
+
+		for (auto x = 0; x < L; x++)
+		{
+			for (auto z = 0; z < L; z++)
+			{
+				const auto height = terrain_height((coord.x * L) + x, (coord.z * L) + z, 100);
+
+				for (auto y = 0; y <= height; y++)
+				{
+					chunk[y / L].set(x, y % L, z, terrain_type(y, height));
+				}
+			}
+		}
+
+		for (auto i = 0; i < geo::Chunk::CHUNK_HEIGHT; i++)
+		{
+			chunk[i].compact();
+		}
+	}
+
+	// rolling terrain around y = 100 in tall columns: only the subchunks the surface passes through hold voxels
+	void benchmark_columns()
+	{
+		constexpr auto L = geo::Subchunk::CHUNK_LENGTH;
+		constexpr auto RADIUS = 8;
+
+		geo::World world{};
+
+		for (auto cx = -RADIUS; cx < RADIUS; cx++)
+		{
+			for (auto cz = -RADIUS; cz < RADIUS; cz++)
+			{
+				auto& chunk = world.load({ cx, 0, cz });
+
+				for (auto x = 0; x < L; x++)
+				{
+					for (auto z = 0; z < L; z++)
+					{
+						const auto wx = (cx * L) + x;
+						const auto wz = (cz * L) + z;
+						const auto height = terrain_height(wx, wz, 100);
+
+						for (auto y = 0; y <= height; y++)
+						{
+							chunk[y / L].set(x, y % L, z, terrain_type(y, height));
+						}
+					}
+				}
+
+				for (auto i = 0uz; i < geo::Chunk::CHUNK_HEIGHT; i++)
+				{
+					chunk[i].compact();
+				}
+			}
+		}
+
+		auto subchunks = 0uz, uniform = 0uz, memory = 0uz;
+
+		for (const auto& [coord, chunk] : world)
+		{
+			for (auto i = 0uz; i < geo::Chunk::CHUNK_HEIGHT; i++)
+			{
+				subchunks++;
+				uniform += (*chunk)[i].uniform() ? 1 : 0;
+			}
+
+			memory += chunk->memory();
+		}
+
+		geo::Mesh mesh{};
+
+		const auto start = clock_type::now();
+
+		for (const auto& [coord, chunk] : world)
+		{
+			for (auto i = 0uz; i < geo::Chunk::CHUNK_HEIGHT; i++)
+			{
+				geo::build_mesh((*chunk)[i], mesh, geo::MeshMode::BINARY, world.neighbors(coord, i));
+			}
+		}
+
+		std::printf("columns: %zu of %zu subchunks uniform, %.1f KiB of voxel storage, meshed in %.2f ms (%zu faces)\n",
+			uniform, subchunks, memory / 1024.0, milliseconds_since(start), mesh.faces());
+	}
+
+	// meshes a field of columns through a mesh cache twice: the first pass only reuses meshes of identical
+	// subchunks, the second is what remeshing unchanged terrain costs. distinct keys bound the gpu copies needed
+	void benchmark_mesh_cache()
+	{
+		constexpr auto RADIUS = 8;
+
+		geo::World world{};
+
+		for (auto cx = -RADIUS; cx < RADIUS; cx++)
+		{
+			for (auto cz = -RADIUS; cz < RADIUS; cz++)
+			{
+				generate_column(world.load({ cx, 0, cz }), { cx, 0, cz });
+			}
+		}
+
+		geo::Mesh mesh{};
+
+		auto start = clock_type::now();
+
+		for (const auto& [coord, chunk] : world)
+		{
+			for (auto i = 0uz; i < geo::Chunk::CHUNK_HEIGHT; i++)
+			{
+				mesh.clear();
+				geo::build_mesh((*chunk)[i], mesh, geo::MeshMode::BINARY, world.neighbors(coord, i));
+			}
+		}
+
+		const auto uncached = milliseconds_since(start);
+
+		geo::MeshCache cache{};
+		std::unordered_set<geo::MeshKey, geo::MeshKeyHash> keys{};
+
+		auto meshes = 0uz;
+		double passes[2]{};
+
+		for (auto& pass : passes)
+		{
+			start = clock_type::now();
+
+			for (const auto& [coord, chunk] : world)
+			{
+				for (auto i = 0uz; i < geo::Chunk::CHUNK_HEIGHT; i++)
+				{
+					mesh.clear();
+
+					if (const auto key = geo::build_mesh(cache, (*chunk)[i], mesh, geo::MeshMode::BINARY, world.neighbors(coord, i)); key.hash != 0)
+					{
+						keys.insert(key);
+						meshes++;
+					}
+				}
+			}
+
+			pass = milliseconds_since(start);
+		}
+
+		const auto stats = cache.stats();
+
+		std::printf("mesh cache: uncached %.2f ms, first pass %.2f ms, second pass %.2f ms; %zu hits, %zu misses, %zu distinct of %zu meshes, %.1f KiB cached\n",
+			uncached, passes[0], passes[1], stats.hits, stats.misses, keys.size(), meshes / 2, cache.memory() / 1024.0);
+	}
+
+	// a 32x32 column view distance of subchunk boxes around a camera looking along -z with a 90 degree
+	// field of view, culled the way the renderer does it every frame
+	void benchmark_frustum()
+	{
+		constexpr auto RADIUS = 16;
+		constexpr auto SPAN = 2.0f * geo::Subchunk::CHUNK_LENGTH;
+		constexpr auto FRAMES = 100;
+
+		// column-major perspective projection, near 1 and far 10000, square aspect
+		constexpr auto NEAR = 1.0f, FAR = 10000.0f;
+
+		float pv[16]{};
+		pv[0] = 1.0f;
+		pv[5] = 1.0f;
+		pv[10] = -(FAR + NEAR) / (FAR - NEAR);
+		pv[11] = -1.0f;
+		pv[14] = -(2.0f * FAR * NEAR) / (FAR - NEAR);
+
+		const geo::Frustum frustum{ pv };
+
+		geo::FrustumCuller culler{};
+
+		for (auto x = -RADIUS; x < RADIUS; x++)
+		{
+			for (auto z = -RADIUS; z < RADIUS; z++)
+			{
+				for (auto y = -4; y < 4; y++)
+				{
+					const std::array<float, 3> min{ x * SPAN, y * SPAN, z * SPAN };
+					culler.add(geo::Aabb{ min, { min[0] + SPAN, min[1] + SPAN, min[2] + SPAN } });
+				}
+			}
+		}
+
+		std::vector<std::uint32_t> visible{};
+		visible.reserve(culler.size());
+
+		const auto start = clock_type::now();
+
+		for (auto frame = 0; frame < FRAMES; frame++)
+		{
+			visible.clear();
+			culler.cull(frustum, visible);
+		}
+
+		const auto elapsed = milliseconds_since(start) / FRAMES;
+
+		std::printf("frustum: %zu boxes in %.3f ms per frame, %zu visible, %zu culled (%.0f%%)\n",
+			culler.size(), elapsed, visible.size(), culler.size() - visible.size(), 100.0 * (culler.size() - visible.size()) / culler.size());
+	}
+
+	// remeshing churn in a gpu arena: mesh-sized ranges are released and reallocated at random, then
+	// compaction runs in per-frame budgets until the free space is back in one piece
+	void benchmark_ranges()
+	{
+		constexpr auto MESHES = 4096uz;
+		constexpr auto ROUNDS = 16uz;
+		constexpr auto BUDGET = 1uz << 16;
+
+		std::mt19937 random{ 1 };
+		std::uniform_int_distribution<std::size_t> sizes{ 64, 4096 };
+
+		geo::RangeAllocator ranges{ 1 << 20 };
+		std::vector<geo::RangeAllocator::Handle> handles{};
+
+		const auto allocate = [&]()
+		{
+			const auto size = sizes(random);
+			auto handle = ranges.allocate(size);
+
+			if (handle == geo::RangeAllocator::INVALID)
+			{
+				ranges.grow(ranges.capacity() * 2);
+				handle = ranges.allocate(size);
+			}
+
+			return handle;
+		};
+
+		for (auto i = 0uz; i < MESHES; i++)
+		{
+			handles.emplace_back(allocate());
+		}
+
+		auto reallocations = 0uz;
+		auto start = clock_type::now();
+
+		for (auto round = 0uz; round < ROUNDS; round++)
+		{
+			for (auto& handle : handles)
+			{
+				if (random() % 4 == 0)
+				{
+					ranges.release(handle);
+					handle = allocate();
+					reallocations++;
+				}
+			}
+		}
+
+		const auto churn = milliseconds_since(start);
+		const auto before = ranges.stats();
+
+		auto frames = 0uz;
+		auto moved = 0uz;
+
+		start = clock_type::now();
+
+		while (ranges.stats().holes > 1)
+		{
+			moved += ranges.compact(BUDGET, [](auto, std::size_t, std::size_t, std::size_t) {});
+			frames++;
+		}
+
+		const auto compaction = milliseconds_since(start);
+		const auto after = ranges.stats();
+
+		std::printf("ranges: %zu reallocations in %.2f ms; %zu/%zu used in %zu holes, %.0f%% fragmented; compacted in %zu frames (%zu moved, %.2f ms) to %zu holes, %.0f%% fragmented\n",
+			reallocations, churn, before.used, before.capacity, before.holes, before.fragmentation() * 100.0, frames, moved, compaction, after.holes, after.fragmentation() * 100.0);
+	}
+
+	// the same 128^3 region of terrain cut into LENGTH^3 subchunks, with one draw call per non-empty mesh
+	template<std::size_t LENGTH>
+	void benchmark_size()
+	{
+		using subchunk_type = geo::BasicSubchunk<LENGTH>;
+
+		constexpr auto L = subchunk_type::CHUNK_LENGTH;
+		constexpr auto REGION = 128;
+		constexpr auto N = REGION / L;
+
+		std::vector<subchunk_type> subchunks(N * N * N);
+
+		const auto at = [&](int x, int y, int z) -> subchunk_type*
+		{
+			if (x < 0 || y < 0 || z < 0 || x >= N || y >= N || z >= N)
+			{
+				return nullptr;
+			}
+
+			return &subchunks[(((x * N) + y) * N) + z];
+		};
+
+		for (auto x = 0; x < REGION; x++)
+		{
+			for (auto z = 0; z < REGION; z++)
+			{
+				const auto height = terrain_height(x, z, 64);
+
+				for (auto y = 0; y <= height; y++)
+				{
+					at(x / L, y / L, z / L)->set(x % L, y % L, z % L, terrain_type(y, height));
+				}
+			}
+		}
+
+		for (auto& subchunk : subchunks)
+		{
+			subchunk.compact();
+		}
+
+		const auto neighbors = [&](int x, int y, int z)
+		{
+			geo::BasicNeighbors<subchunk_type> result{};
+
+			for (auto f = 0; f < 6; f++)
+			{
+				std::array<int, 3> p{ x, y, z };
+				p[geo::face_axis[f]] += geo::face_direction[f];
+				result[f] = at(p[0], p[1], p[2]);
+			}
+
+			return result;
+		};
+
+		std::vector<geo::Mesh> meshes(subchunks.size());
+
+		auto start = clock_type::now();
+
+		for (auto x = 0; x < N; x++)
+		{
+			for (auto y = 0; y < N; y++)
+			{
+				for (auto z = 0; z < N; z++)
+				{
+					geo::build_mesh(*at(x, y, z), meshes[(((x * N) + y) * N) + z], geo::MeshMode::BINARY, neighbors(x, y, z));
+				}
+			}
+		}
+
+		const auto mesh_time = milliseconds_since(start);
+
+		auto draws = 0uz, faces = 0uz, voxel_bytes = 0uz, mesh_bytes = 0uz;
+
+		for (auto i = 0uz; i < subchunks.size(); i++)
+		{
+			draws += meshes[i].vertices.empty() ? 0 : 1;
+			faces += meshes[i].faces();
+			voxel_bytes += sizeof(subchunk_type) + subchunks[i].memory();
+			mesh_bytes += (meshes[i].vertices.size() * sizeof(geo::Vertex)) + (meshes[i].indices.size() * sizeof(GLuint));
+		}
+
+		// dig and refill one surface block, rebuilding the mesh that owns it each time
+		constexpr auto EDITS = 64;
+
+		const auto height = terrain_height(REGION / 2, REGION / 2, 64);
+		const auto [ex, ey, ez] = std::array<int, 3>{ REGION / 2, height, REGION / 2 };
+
+		auto& edited = *at(ex / L, ey / L, ez / L);
+		auto& edited_mesh = meshes[((((ex / L) * N) + (ey / L)) * N) + (ez / L)];
+
+		start = clock_type::now();
+
+		for (auto i = 0; i < EDITS; i++)
+		{
+			edited.set(ex % L, ey % L, ez % L, (i % 2 == 0) ? geo::AIR : terrain_type(ey, height));
+
+			edited_mesh.clear();
+			geo::build_mesh(edited, edited_mesh, geo::MeshMode::BINARY, neighbors(ex / L, ey / L, ez / L));
+		}
+
+		const auto remesh = milliseconds_since(start) * 1000.0 / EDITS;
+
+		std::printf("%2d^3 subchunks: %4zu subchunks, %3zu draw calls, meshed in %6.2f ms, %7.1f KiB voxels, %7.1f KiB mesh, %6zu faces, remesh after edit %7.1f us\n",
+			L, subchunks.size(), draws, mesh_time, voxel_bytes / 1024.0, mesh_bytes / 1024.0, faces, remesh);
+	}
+
+	// streams a band of columns along x the way a moving player would: columns ahead are loaded and
+	// generated, columns behind are unloaded. once the pools have warmed up none of it touches the heap
+	void benchmark_streaming()
+	{
+		constexpr auto RADIUS = 4;
+		constexpr auto WARMUP = 2 * RADIUS + 2;
+		constexpr auto STEPS = 64;
+
+		geo::World world{};
+
+		auto warm = 0uz, loads = 0uz;
+
+		const auto start = clock_type::now();
+
+		for (auto step = 0; step < WARMUP + STEPS; step++)
+		{
+			if (step == WARMUP)
+			{
+				warm = heap_allocations.load();
+			}
+
+			for (auto cz = -RADIUS; cz <= RADIUS; cz++)
+			{
+				world.unload({ step - RADIUS - 1, 0, cz });
+
+				const auto coord = geo::ChunkCoord{ step + RADIUS, 0, cz };
+
+				if (world.find(coord) != nullptr)
+				{
+					continue;
+				}
+
+				generate_column(world.load(coord), coord);
+				loads++;
+			}
+		}
+
+		const auto steady = heap_allocations.load() - warm;
+		const auto chunks = world.pool().stats();
+		const auto storage = geo::storage_pool<geo::Subchunk::CHUNK_LENGTH>().stats();
+
+		std::printf("streaming: %zu column loads in %.2f ms, %zu heap allocations after warmup; chunk pool %zu blocks %.1f KiB, storage pool %zu blocks %.1f KiB\n",
+			loads, milliseconds_since(start), steady, chunks.allocations, chunks.bytes / 1024.0, storage.allocations, storage.bytes / 1024.0);
+	}
+
+	// a player pacing back and forth along x, touching every column within view each step;
+	// shows how the hot and compressed budgets trade regeneration against resident memory
+	void benchmark_cache(geo::ChunkCache::Budget budget)
+	{
+		constexpr auto VIEW = 6;
+		constexpr auto TRACK = 48;
+		constexpr auto STEPS = 4 * TRACK;
+
+		geo::World world{};
+		geo::ChunkCache cache{ world, budget };
+
+		const auto start = clock_type::now();
+
+		for (auto step = 0; step < STEPS; step++)
+		{
+			// there and back again
+			const auto px = (step % (2 * TRACK) < TRACK) ? step % TRACK : TRACK - (step % TRACK);
+
+			for (auto cx = px - VIEW; cx <= px + VIEW; cx++)
+			{
+				for (auto cz = -VIEW; cz <= VIEW; cz++)
+				{
+					const auto coord = geo::ChunkCoord{ cx, 0, cz };
+
+					if (cache.find(coord) == nullptr)
+					{
+						generate_column(cache.load(coord), coord);
+					}
+				}
+			}
+
+			cache.enforce(geo::ChunkCoord{ px, 0, 0 });
+		}
+
+		const auto& stats = cache.stats();
+
+		std::printf("cache %5zu KiB hot %5zu KiB compressed: %.0f ms, %zu hits, %zu compressed hits, %zu misses, %zu compressions, %zu drops, %zu KiB + %zu KiB resident\n",
+			budget.hot / 1024, budget.compressed / 1024, milliseconds_since(start), stats.hits, stats.compressed_hits, stats.misses,
+			stats.compressions, stats.drops, cache.hot_memory() / 1024, cache.compressed_memory() / 1024);
+	}
+}
+
+int main()
+{
+	auto& types = geo::registry();
+
+	types.add({ "stone", fx::vec3{ 0.45f, 0.45f, 0.48f }, 1.0f, geo::BLOCK_OPAQUE });
+	types.add({ "dirt",  fx::vec3{ 0.47f, 0.33f, 0.20f }, 1.0f, geo::BLOCK_OPAQUE });
+	types.add({ "grass", fx::vec3{ 0.30f, 0.62f, 0.24f }, 1.0f, geo::BLOCK_OPAQUE });
+
+	geo::Scheduler scheduler{};
+
+	const auto start = clock_type::now();
+	stress_scheduler(scheduler);
+
+	const auto stats = scheduler.stats();
+	std::printf("scheduler stress: %.2f ms, %zu jobs executed, %zu stolen, %zu injected\n",
+		milliseconds_since(start), stats.executed, stats.stolen, stats.injected);
+
+	check_meshers<8>();
+	check_meshers<16>();
+	check_meshers<32>();
+	check_meshers<64>();
+
+	benchmark_meshing(scheduler);
+	benchmark_culling();
+	benchmark_columns();
+	benchmark_mesh_cache();
+	benchmark_ranges();
+	benchmark_frustum();
+	benchmark_streaming();
+
+	benchmark_cache({ 1 << 20, 64 << 10 });
+	benchmark_cache({ 1 << 20, 1 << 20 });
+	benchmark_cache({ 4 << 20, 1 << 20 });
+
+	benchmark_layout<geo::XyzLayout>("xyz");
+	benchmark_layout<geo::YzxLayout>("yzx");
+	benchmark_layout<geo::MortonLayout>("morton");
+
+	benchmark_size<16>();
+	benchmark_size<32>();
+	benchmark_size<64>();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+#ifndef GEO_BLOCK_H
+#define GEO_BLOCK_H
+
+#include <cassert>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+#include "flux/types.h"
+
+#include "palette.h"
+
+namespace geo
+{
+	enum BlockFlags : std::uint32_t
+	{
+		BLOCK_NONE        = 0,
+		BLOCK_OPAQUE      = 1 << 0,
+		BLOCK_TRANSPARENT = 1 << 1,
+		BLOCK_LIQUID      = 1 << 2,
+		BLOCK_EMISSIVE    = 1 << 3,
+	};
+
+	// immutable per-type data shared by every voxel of that type
+	struct BlockType
+	{
+		std::string_view name;
+		fx::vec3 color;
+		float opacity;
+		std::uint32_t flags;
+	};
+
+	class BlockRegistry
+	{
+	private:
+		std::vector<BlockType> _types;
+
+	public:
+		BlockId add(const BlockType& type)
+		{
+			// ids past what BlockId holds would wrap around onto existing types
+			assert(_types.size() <= std::numeric_limits<BlockId>::max());
+
+			_types.emplace_back(type);
+			return static_cast<BlockId>(_types.size() - 1);
+		}
+
+	public:
+		const BlockType& operator[](BlockId id) const
+		{
+			assert(id < _types.size());
+			return _types[id];
+		}
+
+		bool opaque(BlockId id) const
+		{
+			assert(id < _types.size());
+			return (_types[id].flags & BLOCK_OPAQUE) != 0;
+		}
+
+		std::size_t size() const
+		{
+			return _types.size();
+		}
+
+	public:
+		static BlockRegistry& instance()
+		{
+			static BlockRegistry registry{};
+			return registry;
+		}
+
+	private:
+		BlockRegistry()
+		{
+			// id 0 is always air so freshly allocated storage reads as empty
+			_types.emplace_back(BlockType{ "air", fx::broadcast<3>(0.0f), 0.0f, BLOCK_TRANSPARENT });
+		}
+	};
+
+	inline BlockRegistry& registry()
+	{
+		return BlockRegistry::instance();
+	}
+}
+
+#endif
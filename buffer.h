@@ -0,0 +1,87 @@
+#ifndef GEO_BUFFER_H
+#define GEO_BUFFER_H
+
+#include <cstddef>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+// let's use attribute string names instead of IDs
+inline GLuint _attribute_id = 0;
+
+template<typename T>
+class buffer
+{
+private:
+	const GLuint _type;
+	GLuint _buffer_id;
+
+private:
+	std::vector<T>& _data;
+
+public:
+	// binds the buffer without uploading anything
+	void attach() const
+	{
+		glBindBuffer(_type, _buffer_id);
+	}
+
+	// binds the buffer to a target other than the one it was made for
+	void attach(const GLuint type) const
+	{
+		glBindBuffer(type, _buffer_id);
+	}
+
+	void bind(const GLuint hint = GL_STATIC_DRAW)
+	{
+		const auto stride = sizeof(T);
+		const auto size = _data.size();
+
+		glBindBuffer(_type, _buffer_id);
+#pragma message("SUPPORT MORE THAN JUST STATIC DRAW WHEN POSSIBLE!")
+		glBufferData(_type, stride * size, _data.data(), hint);
+	}
+
+	// re-uploads count elements starting at first, leaving the rest of the buffer alone
+	void update(const std::size_t first, const std::size_t count)
+	{
+		glBindBuffer(_type, _buffer_id);
+		glBufferSubData(_type, sizeof(T) * first, sizeof(T) * count, _data.data() + first);
+	}
+
+	void add_attribute(const GLuint element_count, const GLuint element_type, const GLuint stride, const std::size_t offset)
+	{
+		std::cout << "attribute id: " << _attribute_id << std::endl;
+		glVertexAttribPointer(_attribute_id, element_count, element_type, GL_FALSE, stride, reinterpret_cast<void*>(offset));
+		glEnableVertexAttribArray(_attribute_id);
+		_attribute_id++;
+	}
+
+	void base()
+	{
+		glBindBufferBase(_type, _attribute_id, _buffer_id);
+	}
+
+	void base(const GLuint binding)
+	{
+		glBindBufferBase(_type, binding, _buffer_id);
+	}
+
+public:
+	buffer(const GLuint type, std::vector<T>& data)
+		: _type{ type }, _data{ data }
+	{
+		glGenBuffers(1, &_buffer_id);
+		bind();
+	}
+
+	~buffer()
+	{
+		glDeleteBuffers(1, &_buffer_id);
+	}
+
+	buffer(const buffer&) = delete;
+	buffer& operator=(const buffer&) = delete;
+};
+
+#endif
@@ -0,0 +1,505 @@
+#ifndef GEO_CACHE_H
+#define GEO_CACHE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <list>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "world.h"
+
+namespace geo
+{
+	namespace detail
+	{
+		inline void put_varint(std::vector<std::byte>& out, std::size_t value)
+		{
+			while (value >= 0x80)
+			{
+				out.emplace_back(static_cast<std::byte>((value & 0x7F) | 0x80));
+				value >>= 7;
+			}
+
+			out.emplace_back(static_cast<std::byte>(value));
+		}
+
+		inline bool get_varint(std::span<const std::byte>& in, std::size_t& value)
+		{
+			value = 0;
+
+			for (auto shift = 0; shift < 64; shift += 7)
+			{
+				if (in.empty())
+				{
+					return false;
+				}
+
+				const auto byte = std::to_integer<std::size_t>(in.front());
+				in = in.subspan(1);
+
+				value |= (byte & 0x7F) << shift;
+
+				if ((byte & 0x80) == 0)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		// ids outside what BlockId holds or the registry knows would alias real blocks or index past the types
+		inline bool valid_block(std::size_t id)
+		{
+			return id <= std::numeric_limits<BlockId>::max() && id < registry().size();
+		}
+	}
+
+	// chunk codec for cold storage: each subchunk is either its uniform block id or run-length encoded
+	// block ids in layout order, with every count stored as a varint. terrain is mostly long runs, so
+	// chunks typically shrink by one to two orders of magnitude
+	inline void compress_chunk(const Chunk& chunk, std::vector<std::byte>& out)
+	{
+		constexpr auto VOLUME = static_cast<std::size_t>(Subchunk::CHUNK_VOLUME);
+
+		out.clear();
+
+		for (auto i = 0; i < Chunk::CHUNK_HEIGHT; i++)
+		{
+			const auto& subchunk = chunk[i];
+
+			if (subchunk.uniform())
+			{
+				out.emplace_back(std::byte{ 0 });
+				detail::put_varint(out, subchunk.get(0));
+				continue;
+			}
+
+			out.emplace_back(std::byte{ 1 });
+
+			auto run = 0uz;
+			auto current = subchunk.get(0);
+
+			for (auto index = 0uz; index < VOLUME; index++)
+			{
+				const auto id = subchunk.get(index);
+
+				if (id != current)
+				{
+					detail::put_varint(out, run);
+					detail::put_varint(out, current);
+
+					run = 0;
+					current = id;
+				}
+
+				run++;
+			}
+
+			detail::put_varint(out, run);
+			detail::put_varint(out, current);
+		}
+	}
+
+	// returns false, leaving chunk partially written, if data is truncated, malformed or names unknown blocks
+	inline bool decompress_chunk(std::span<const std::byte> in, Chunk& chunk)
+	{
+		constexpr auto VOLUME = static_cast<std::size_t>(Subchunk::CHUNK_VOLUME);
+
+		for (auto i = 0; i < Chunk::CHUNK_HEIGHT; i++)
+		{
+			auto& subchunk = chunk[i];
+
+			if (in.empty())
+			{
+				return false;
+			}
+
+			const auto tag = in.front();
+			in = in.subspan(1);
+
+			auto id = 0uz;
+
+			if (tag == std::byte{ 0 })
+			{
+				if (!detail::get_varint(in, id) || !detail::valid_block(id))
+				{
+					return false;
+				}
+
+				subchunk.fill(static_cast<BlockId>(id));
+				continue;
+			}
+
+			subchunk.fill(AIR);
+
+			for (auto index = 0uz, run = 0uz; index < VOLUME; index += run)
+			{
+				if (!detail::get_varint(in, run) || !detail::get_varint(in, id) || run == 0 || index + run > VOLUME || !detail::valid_block(id))
+				{
+					return false;
+				}
+
+				for (auto j = index; j < index + run; j++)
+				{
+					subchunk.set(j, static_cast<BlockId>(id));
+				}
+			}
+		}
+
+		return in.empty();
+	}
+
+	// keeps a World within a memory budget. chunks go through the cache, which tracks how recently each
+	// was used: once uncompressed chunks exceed the hot budget they are compressed in RAM, and once
+	// compressed chunks exceed the cold budget they are written to disk, or dropped when there is no
+	// directory. chunks farthest from the focus given to enforce() go first, the least recently used among
+	// equals; without a focus it is plain LRU. touching a cold chunk brings it back.
+	// chunk references stay valid until the next enforce()
+	class ChunkCache
+	{
+	public:
+		struct Budget
+		{
+			std::size_t hot;
+			std::size_t compressed;
+		};
+
+		struct Stats
+		{
+			std::size_t hits;
+			std::size_t compressed_hits;
+			std::size_t disk_hits;
+			std::size_t misses;
+
+			std::size_t compressions;
+			std::size_t evictions;
+			std::size_t drops;
+
+			// cold chunks that failed to decode and were forgotten
+			std::size_t corrupt;
+		};
+
+	private:
+		enum class Tier
+		{
+			HOT,
+			COMPRESSED,
+			DISK,
+		};
+
+		struct Entry
+		{
+			Tier tier;
+			std::list<ChunkCoord>::iterator position;
+			std::vector<std::byte> data;
+		};
+
+	private:
+		World& _world;
+		Budget _budget;
+		std::filesystem::path _directory;
+
+		std::unordered_map<ChunkCoord, Entry, ChunkCoordHash> _entries;
+
+		// most recently used at the front
+		std::list<ChunkCoord> _hot;
+		std::list<ChunkCoord> _cold;
+
+		std::size_t _compressed_bytes;
+		Stats _stats;
+
+	private:
+		std::filesystem::path path(const ChunkCoord& coord) const
+		{
+			return _directory / (std::to_string(coord.x) + "_" + std::to_string(coord.y) + "_" + std::to_string(coord.z) + ".chunk");
+		}
+
+		bool write(const ChunkCoord& coord, const std::vector<std::byte>& data) const
+		{
+			std::ofstream file{ path(coord), std::ios::binary | std::ios::trunc };
+			file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+			return file.good();
+		}
+
+		bool read(const ChunkCoord& coord, std::vector<std::byte>& data) const
+		{
+			std::ifstream file{ path(coord), std::ios::binary };
+
+			if (!file.good())
+			{
+				return false;
+			}
+
+			std::error_code error{};
+			const auto size = std::filesystem::file_size(path(coord), error);
+
+			if (error)
+			{
+				return false;
+			}
+
+			data.resize(size);
+			file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(size));
+
+			return file.good();
+		}
+
+		// nullptr, with the chunk forgotten everywhere, when its data does not decode
+		Chunk* promote(const ChunkCoord& coord, Entry& entry)
+		{
+			auto& chunk = _world.load(coord);
+			const auto decoded = decompress_chunk(entry.data, chunk);
+
+			if (entry.tier == Tier::COMPRESSED)
+			{
+				_compressed_bytes -= entry.data.size();
+				_cold.erase(entry.position);
+			}
+
+			else
+			{
+				std::error_code error{};
+				std::filesystem::remove(path(coord), error);
+			}
+
+			if (!decoded)
+			{
+				_world.unload(coord);
+				_entries.erase(coord);
+				_stats.corrupt++;
+
+				return nullptr;
+			}
+
+			entry.data = {};
+			entry.tier = Tier::HOT;
+
+			_hot.emplace_front(coord);
+			entry.position = _hot.begin();
+
+			return &chunk;
+		}
+
+		// the order chunks in a tier give way in: farthest from focus first, least recently used among equals
+		static std::vector<ChunkCoord> victims(const std::list<ChunkCoord>& tier, const std::optional<ChunkCoord>& focus)
+		{
+			std::vector<ChunkCoord> result{ tier.rbegin(), tier.rend() };
+
+			if (focus)
+			{
+				const auto distance = [&](const ChunkCoord& coord)
+				{
+					const auto dx = static_cast<std::int64_t>(coord.x) - focus->x;
+					const auto dy = static_cast<std::int64_t>(coord.y) - focus->y;
+					const auto dz = static_cast<std::int64_t>(coord.z) - focus->z;
+
+					return (dx * dx) + (dy * dy) + (dz * dz);
+				};
+
+				std::ranges::stable_sort(result, std::ranges::greater{}, distance);
+			}
+
+			return result;
+		}
+
+	public:
+		// the chunk at coord if it is known in any tier, decompressed if necessary
+		Chunk* find(const ChunkCoord& coord)
+		{
+			const auto found = _entries.find(coord);
+
+			if (found == _entries.end())
+			{
+				return nullptr;
+			}
+
+			auto& entry = found->second;
+
+			switch (entry.tier)
+			{
+			case Tier::HOT:
+				if (const auto chunk = _world.find(coord))
+				{
+					_stats.hits++;
+					_hot.splice(_hot.begin(), _hot, entry.position);
+					return chunk;
+				}
+
+				// unloaded from the world behind the cache's back
+				_hot.erase(entry.position);
+				_entries.erase(found);
+				return nullptr;
+
+			case Tier::COMPRESSED:
+				if (const auto chunk = promote(coord, entry))
+				{
+					_stats.compressed_hits++;
+					return chunk;
+				}
+
+				return nullptr;
+
+			case Tier::DISK:
+				if (!read(coord, entry.data))
+				{
+					// the file went missing or is unreadable, so forget the chunk
+					_entries.erase(found);
+					return nullptr;
+				}
+
+				if (const auto chunk = promote(coord, entry))
+				{
+					_stats.disk_hits++;
+					return chunk;
+				}
+
+				return nullptr;
+			}
+
+			return nullptr;
+		}
+
+		// like find(), but creates an empty chunk when coord is not known anywhere, which counts as a miss
+		Chunk& load(const ChunkCoord& coord)
+		{
+			if (const auto chunk = find(coord))
+			{
+				return *chunk;
+			}
+
+			_stats.misses++;
+
+			_hot.emplace_front(coord);
+			_entries.insert_or_assign(coord, Entry{ Tier::HOT, _hot.begin(), {} });
+
+			return _world.load(coord);
+		}
+
+		// compresses and evicts chunks until both budgets hold, farthest from focus first when one is given
+		void enforce(std::optional<ChunkCoord> focus = std::nullopt)
+		{
+			// forget hot chunks unloaded from the world behind the cache's back
+			for (auto it = _hot.begin(); it != _hot.end();)
+			{
+				if (_world.find(*it) == nullptr)
+				{
+					_entries.erase(*it);
+					it = _hot.erase(it);
+				}
+
+				else
+				{
+					++it;
+				}
+			}
+
+			auto hot = hot_memory();
+
+			for (const auto& coord : victims(_hot, focus))
+			{
+				if (hot <= _budget.hot)
+				{
+					break;
+				}
+
+				auto& entry = _entries.at(coord);
+				const auto chunk = _world.find(coord);
+
+				_hot.erase(entry.position);
+				hot -= sizeof(Chunk) + chunk->memory();
+
+				compress_chunk(*chunk, entry.data);
+				entry.data.shrink_to_fit();
+				_world.unload(coord);
+
+				entry.tier = Tier::COMPRESSED;
+				_cold.emplace_front(coord);
+				entry.position = _cold.begin();
+
+				_compressed_bytes += entry.data.size();
+				_stats.compressions++;
+			}
+
+			for (const auto& coord : victims(_cold, focus))
+			{
+				if (_compressed_bytes <= _budget.compressed)
+				{
+					break;
+				}
+
+				auto& entry = _entries.at(coord);
+				_cold.erase(entry.position);
+				_compressed_bytes -= entry.data.size();
+
+				if (!_directory.empty() && write(coord, entry.data))
+				{
+					entry.data = {};
+					entry.tier = Tier::DISK;
+					_stats.evictions++;
+				}
+
+				else
+				{
+					_entries.erase(coord);
+					_stats.drops++;
+				}
+			}
+		}
+
+	public:
+		std::size_t hot_memory() const
+		{
+			auto result = 0uz;
+
+			for (const auto& coord : _hot)
+			{
+				// enforce() forgets chunks unloaded behind the cache's back; until then they hold nothing
+				if (const auto chunk = _world.find(coord))
+				{
+					result += sizeof(Chunk) + chunk->memory();
+				}
+			}
+
+			return result;
+		}
+
+		std::size_t compressed_memory() const
+		{
+			return _compressed_bytes;
+		}
+
+		std::size_t size() const
+		{
+			return _entries.size();
+		}
+
+		const Stats& stats() const
+		{
+			return _stats;
+		}
+
+	public:
+		// evicted chunks are written under directory; leave it empty to drop them instead
+		ChunkCache(World& world, Budget budget, std::filesystem::path directory = {})
+			: _world{ world }, _budget{ budget }, _directory{ std::move(directory) }, _compressed_bytes{ 0 }, _stats{}
+		{
+			if (!_directory.empty())
+			{
+				std::error_code error{};
+				std::filesystem::create_directories(_directory, error);
+			}
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,340 @@
+#ifndef GEO_CHUNK_H
+#define GEO_CHUNK_H
+
+#include <memory>
+#include <span>
+
+#include "block.h"
+#include "layout.h"
+#include "occupancy.h"
+#include "palette.h"
+
+namespace geo
+{
+	// integer coordinates of a cell of the world: chunks are keyed in chunk units,
+	// meshes in subchunk units (see Chunk::subchunk_coord)
+	struct ChunkCoord
+	{
+		int x, y, z;
+
+		bool operator==(const ChunkCoord&) const = default;
+	};
+
+	constexpr std::uint64_t hash(const ChunkCoord& coord)
+	{
+		// large odd multipliers per axis, then a final avalanche so neighboring coordinates scatter
+		auto h = (static_cast<std::uint64_t>(static_cast<std::uint32_t>(coord.x)) * 0x9E3779B97F4A7C15ull) ^
+				 (static_cast<std::uint64_t>(static_cast<std::uint32_t>(coord.y)) * 0xC2B2AE3D27D4EB4Full) ^
+				 (static_cast<std::uint64_t>(static_cast<std::uint32_t>(coord.z)) * 0x165667B19E3779F9ull);
+
+		h ^= h >> 31;
+		h *= 0xD6E8FEB86659FD93ull;
+		h ^= h >> 32;
+
+		return h;
+	}
+
+	struct ChunkCoordHash
+	{
+		std::size_t operator()(const ChunkCoord& coord) const
+		{
+			return static_cast<std::size_t>(hash(coord));
+		}
+	};
+
+	// division and remainder rounding toward negative infinity, for splitting world positions into cells
+	constexpr int floor_div(const int a, const int b)
+	{
+		return (a / b) - (((a % b) != 0 && ((a < 0) != (b < 0))) ? 1 : 0);
+	}
+
+	constexpr int floor_mod(const int a, const int b)
+	{
+		return a - (floor_div(a, b) * b);
+	}
+
+	// what a subchunk allocates once it stops being uniform: its voxels, and the occupancy kept in step with them
+	template<std::size_t LENGTH>
+	struct SubchunkStorage
+	{
+		PaletteStorage<LENGTH * LENGTH * LENGTH> blocks;
+		Occupancy<LENGTH> occupancy;
+	};
+
+	// subchunk storage is recycled through one pool per length; mesh jobs copy and drop subchunks on worker
+	// threads, so the pool is shared. it is never destroyed, which keeps subchunks in static storage safe
+	template<std::size_t LENGTH>
+	SharedPool<SubchunkStorage<LENGTH>>& storage_pool()
+	{
+		static auto& pool = *new SharedPool<SubchunkStorage<LENGTH>>{};
+		return pool;
+	}
+
+	template<std::size_t LENGTH>
+	struct StorageRelease
+	{
+		void operator()(SubchunkStorage<LENGTH>* storage) const
+		{
+			storage_pool<LENGTH>().release(storage);
+		}
+	};
+
+	// a LENGTH^3 cube of blocks stored in Layout order. all-air and single-type subchunks, which make up most of real terrain,
+	// are just a tag and a block id; storage is only allocated on the first write that breaks uniformity.
+	// every write also updates the filled and opaque occupancy masks, so meshers never classify voxels themselves
+	template<std::size_t LENGTH, template<std::size_t> typename Layout = DefaultLayout>
+	class BasicSubchunk
+	{
+	public:
+		static constexpr auto CHUNK_LENGTH = static_cast<int>(LENGTH);
+		static constexpr auto CHUNK_VOLUME = CHUNK_LENGTH * CHUNK_LENGTH * CHUNK_LENGTH;
+
+	private:
+		BlockId _uniform;
+		std::unique_ptr<SubchunkStorage<LENGTH>, StorageRelease<LENGTH>> _storage;
+
+	private:
+		// a pooled storage keeps whatever it held last; callers overwrite it right away
+		static auto acquire()
+		{
+			return std::unique_ptr<SubchunkStorage<LENGTH>, StorageRelease<LENGTH>>{ storage_pool<LENGTH>().acquire() };
+		}
+
+		static auto copy(const BasicSubchunk& other)
+		{
+			auto result = (other._storage == nullptr) ? nullptr : acquire();
+
+			if (result != nullptr)
+			{
+				*result = *other._storage;
+			}
+
+			return result;
+		}
+
+		void write(std::size_t index, std::size_t x, std::size_t y, std::size_t z, BlockId id)
+		{
+			const auto& types = registry();
+
+			if (_storage == nullptr)
+			{
+				if (id == _uniform)
+				{
+					return;
+				}
+
+				_storage = acquire();
+				_storage->blocks.fill(_uniform);
+				_storage->occupancy.filled.fill(_uniform != AIR);
+				_storage->occupancy.opaque.fill(types.opaque(_uniform));
+			}
+
+			_storage->blocks.set(index, id);
+			_storage->occupancy.filled.set(x, y, z, id != AIR);
+			_storage->occupancy.opaque.set(x, y, z, types.opaque(id));
+		}
+
+	public:
+		using layout = Layout<LENGTH>;
+
+	public:
+		// every voxel access goes through here
+		static constexpr std::size_t index(std::size_t x, std::size_t y, std::size_t z)
+		{
+			return layout::index(x, y, z);
+		}
+
+	public:
+		BlockId get(std::size_t x, std::size_t y, std::size_t z) const
+		{
+			return get(index(x, y, z));
+		}
+
+		void set(std::size_t x, std::size_t y, std::size_t z, BlockId id)
+		{
+			write(index(x, y, z), x, y, z, id);
+		}
+
+		// by storage index, for code that walks every voxel in layout order
+		BlockId get(std::size_t index) const
+		{
+			return (_storage == nullptr) ? _uniform : _storage->blocks.get(index);
+		}
+
+		void set(std::size_t index, BlockId id)
+		{
+			const auto [x, y, z] = layout::coords(index);
+			write(index, x, y, z, id);
+		}
+
+		bool solid(std::size_t x, std::size_t y, std::size_t z) const
+		{
+			return get(x, y, z) != AIR;
+		}
+
+		void fill(BlockId id)
+		{
+			_storage.reset();
+			_uniform = id;
+		}
+
+		// shrinks the palette, and drops it entirely if edits left a single block type behind
+		void compact()
+		{
+			if (_storage == nullptr)
+			{
+				return;
+			}
+
+			_storage->blocks.compact();
+
+			if (_storage->blocks.palette().size() == 1)
+			{
+				fill(_storage->blocks.palette().front());
+			}
+		}
+
+	public:
+		bool uniform() const
+		{
+			return _storage == nullptr;
+		}
+
+		bool empty() const
+		{
+			return uniform() && _uniform == AIR;
+		}
+
+		// every block id that may occur in the subchunk, possibly including unreferenced ones
+		std::span<const BlockId> palette() const
+		{
+			if (_storage == nullptr)
+			{
+				return { &_uniform, 1 };
+			}
+
+			return _storage->blocks.palette();
+		}
+
+		// voxels holding any block; uniform subchunks share a constant mask
+		const OccupancyMask<LENGTH>& filled() const
+		{
+			if (_storage == nullptr)
+			{
+				return (_uniform == AIR) ? OccupancyMask<LENGTH>::none() : OccupancyMask<LENGTH>::all();
+			}
+
+			return _storage->occupancy.filled;
+		}
+
+		// voxels that hide the faces of their neighbors
+		const OccupancyMask<LENGTH>& opaque() const
+		{
+			if (_storage == nullptr)
+			{
+				return registry().opaque(_uniform) ? OccupancyMask<LENGTH>::all() : OccupancyMask<LENGTH>::none();
+			}
+
+			return _storage->occupancy.opaque;
+		}
+
+		// resident bytes beyond the object itself
+		std::size_t memory() const
+		{
+			return (_storage == nullptr) ? 0 : sizeof(SubchunkStorage<LENGTH>) + _storage->blocks.memory();
+		}
+
+	public:
+		BasicSubchunk& operator=(const BasicSubchunk& other)
+		{
+			if (this != &other)
+			{
+				_uniform = other._uniform;
+				_storage = copy(other);
+			}
+
+			return *this;
+		}
+
+		BasicSubchunk& operator=(BasicSubchunk&&) = default;
+
+	public:
+		BasicSubchunk()
+			: _uniform{ AIR }, _storage{}
+		{
+		}
+
+		BasicSubchunk(const BasicSubchunk& other)
+			: _uniform{ other._uniform }, _storage{ copy(other) }
+		{
+		}
+
+		BasicSubchunk(BasicSubchunk&&) = default;
+	};
+
+	using Subchunk = BasicSubchunk<16>;
+
+	// a vertical column of HEIGHT subchunks, keyed in the world by chunk coordinates
+	template<typename SubchunkType, std::size_t HEIGHT>
+	class BasicChunk
+	{
+	public:
+		using subchunk_type = SubchunkType;
+
+		static constexpr auto CHUNK_HEIGHT = static_cast<int>(HEIGHT);
+
+	private:
+		std::array<SubchunkType, HEIGHT> _subchunks;
+
+	public:
+		constexpr auto& operator[](std::size_t x)
+		{
+			return _subchunks[x];
+		}
+
+		constexpr const auto& operator[](std::size_t x) const
+		{
+			return _subchunks[x];
+		}
+
+	public:
+		// subchunk index of the chunk at coord, in subchunk units
+		static constexpr ChunkCoord subchunk_coord(const ChunkCoord& coord, std::size_t index)
+		{
+			return ChunkCoord{ coord.x, (coord.y * CHUNK_HEIGHT) + static_cast<int>(index), coord.z };
+		}
+
+		// the inverse of subchunk_coord: the column holding a subchunk given in subchunk units, and its index there
+		static constexpr ChunkCoord column_coord(const ChunkCoord& coord)
+		{
+			return ChunkCoord{ coord.x, floor_div(coord.y, CHUNK_HEIGHT), coord.z };
+		}
+
+		static constexpr std::size_t subchunk_index(const ChunkCoord& coord)
+		{
+			return static_cast<std::size_t>(floor_mod(coord.y, CHUNK_HEIGHT));
+		}
+
+		std::size_t memory() const
+		{
+			auto result = 0uz;
+
+			for (const auto& subchunk : _subchunks)
+			{
+				result += subchunk.memory();
+			}
+
+			return result;
+		}
+
+	public:
+		BasicChunk()
+		{
+			_subchunks = {};
+		}
+	};
+
+	using Chunk = BasicChunk<Subchunk, 16>;
+}
+
+#endif
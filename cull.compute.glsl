@@ -0,0 +1,156 @@
+#version 460 core
+
+layout (local_size_x = 64) in;
+
+// see draw_record in main.cpp
+struct Record
+{
+	vec4 lo;
+	vec4 hi;
+	vec4 origin;
+
+	uint count;
+	uint first_index;
+	int base_vertex;
+	uint padding;
+};
+
+// see draw_command in main.cpp
+struct Command
+{
+	uint count;
+	uint instance_count;
+	uint first_index;
+	int base_vertex;
+	uint base_instance;
+};
+
+uniform mat4 cull_pv;
+uniform int cull_records;
+
+// the view the depth pyramid was captured from; boxes are projected with it for the occlusion test,
+// so they land on the texels that hold their part of the scene even after the camera moves
+uniform mat4 hiz_pv;
+
+// 0 until a frame has been drawn into the depth pyramid, 1 when culling from the view it was captured
+// from and 2 once the camera has moved since
+uniform int cull_occlusion;
+
+// the previous frame's depth, each level keeping the farthest depth of the four texels below it
+layout (binding = 0) uniform sampler2D hiz;
+
+// origins are written where world.vertex.glsl reads them, next to the commands that use them
+layout (std430, binding = 4) writeonly buffer Origins
+{
+	vec4 origins[];
+};
+
+layout (std430, binding = 5) readonly buffer Records
+{
+	Record records[];
+};
+
+layout (std430, binding = 6) writeonly buffer Commands
+{
+	Command commands[];
+};
+
+// also the parameter buffer glMultiDrawElementsIndirectCount reads the draw count from
+layout (std430, binding = 7) buffer Count
+{
+	uint draw_count;
+};
+
+bool inside_frustum(const vec3 lo, const vec3 hi)
+{
+	const mat4 rows = transpose(cull_pv);
+
+	// left, right, bottom, top, near, far; only the corner furthest along each plane's normal matters
+	for (int p = 0; p < 6; p++)
+	{
+		const vec4 plane = rows[3] + (((p & 1) == 0) ? rows[p / 2] : -rows[p / 2]);
+		const vec3 corner = mix(lo, hi, greaterThanEqual(plane.xyz, vec3(0.0)));
+
+		if (dot(plane.xyz, corner) + plane.w < 0.0)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool occluded(const vec3 lo, const vec3 hi)
+{
+	vec2 rect_lo = vec2(1.0);
+	vec2 rect_hi = vec2(-1.0);
+	float nearest = 1.0;
+
+	for (int i = 0; i < 8; i++)
+	{
+		const vec3 corner = mix(lo, hi, bvec3((i & 1) != 0, (i & 2) != 0, (i & 4) != 0));
+		const vec4 clip = hiz_pv * vec4(corner, 1.0);
+
+		// boxes reaching behind the camera have no sensible screen rect, so they stay visible
+		if (clip.w <= 0.0)
+		{
+			return false;
+		}
+
+		const vec3 ndc = clip.xyz / clip.w;
+
+		rect_lo = min(rect_lo, ndc.xy);
+		rect_hi = max(rect_hi, ndc.xy);
+		nearest = min(nearest, (ndc.z * 0.5) + 0.5);
+	}
+
+	// the pyramid knows nothing about what lay off screen when it was captured. from the same view that part
+	// is off screen now too, but after the camera moves it may have come into sight
+	if (cull_occlusion == 2 && (any(lessThan(rect_lo, vec2(-1.0))) || any(greaterThan(rect_hi, vec2(1.0)))))
+	{
+		return false;
+	}
+
+	const vec2 uv_lo = clamp((rect_lo * 0.5) + 0.5, 0.0, 1.0);
+	const vec2 uv_hi = clamp((rect_hi * 0.5) + 0.5, 0.0, 1.0);
+
+	// the level at which the rect spans at most two texels each way
+	const vec2 extent = (uv_hi - uv_lo) * vec2(textureSize(hiz, 0));
+	const int level = clamp(int(ceil(log2(max(max(extent.x, extent.y), 1.0)))), 0, textureQueryLevels(hiz) - 1);
+
+	// texels from level 0 pixels, since halving odd sizes leaves each level a little more than half the one
+	// before; hiz.compute.glsl folds the spare row and column into the last texel, which the min matches.
+	// the level's size is halved from level 0 too, as llvmpipe answers textureSize wrongly when the level
+	// differs between invocations
+	const ivec2 pixels = textureSize(hiz, 0);
+	const ivec2 size = max(pixels >> level, ivec2(1));
+	const ivec2 a = clamp(ivec2(uv_lo * vec2(pixels)) >> level, ivec2(0), size - 1);
+	const ivec2 b = clamp(ivec2(uv_hi * vec2(pixels)) >> level, ivec2(0), size - 1);
+
+	const float farthest = max(max(texelFetch(hiz, a, level).r, texelFetch(hiz, ivec2(b.x, a.y), level).r),
+		max(texelFetch(hiz, ivec2(a.x, b.y), level).r, texelFetch(hiz, b, level).r));
+
+	return nearest > farthest;
+}
+
+void main()
+{
+	const uint index = gl_GlobalInvocationID.x;
+
+	if (index >= uint(cull_records))
+	{
+		return;
+	}
+
+	const Record record = records[index];
+
+	if (!inside_frustum(record.lo.xyz, record.hi.xyz) || (cull_occlusion != 0 && occluded(record.lo.xyz, record.hi.xyz)))
+	{
+		return;
+	}
+
+	const uint slot = atomicAdd(draw_count, 1u);
+
+	commands[slot] = Command(record.count, 1u, record.first_index, record.base_vertex, 0u);
+	origins[slot] = record.origin;
+}
@@ -0,0 +1,202 @@
+#ifndef GEO_FRUSTUM_H
+#define GEO_FRUSTUM_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "geometry.h"
+#include "occupancy.h"
+
+namespace geo
+{
+	struct Aabb
+	{
+		std::array<float, 3> min;
+		std::array<float, 3> max;
+
+		// the empty box, which extend() grows from
+		static constexpr Aabb none()
+		{
+			constexpr auto inf = std::numeric_limits<float>::infinity();
+			return Aabb{ { inf, inf, inf }, { -inf, -inf, -inf } };
+		}
+
+		constexpr void extend(const Aabb& other)
+		{
+			for (auto a = 0; a < 3; a++)
+			{
+				min[a] = std::min(min[a], other.min[a]);
+				max[a] = std::max(max[a], other.max[a]);
+			}
+		}
+
+		constexpr bool empty() const
+		{
+			return min[0] > max[0] || min[1] > max[1] || min[2] > max[2];
+		}
+	};
+
+	// the corners a mesh's vertices span, in the corner units of its subchunk
+	inline Aabb mesh_bounds(const Mesh& mesh)
+	{
+		auto result = Aabb::none();
+
+		for (const auto& vertex : mesh.vertices)
+		{
+			const std::array<float, 3> corner{ static_cast<float>(vertex.x()), static_cast<float>(vertex.y()), static_cast<float>(vertex.z()) };
+			result.extend(Aabb{ corner, corner });
+		}
+
+		return result;
+	}
+
+	// the six planes bounding what a view-projection matrix can see, each stored as a, b, c, d with
+	// a*x + b*y + c*z + d >= 0 on the inside. matrix is column-major, the way glUniformMatrix4fv takes it
+	struct Frustum
+	{
+		std::array<std::array<float, 4>, 6> planes;
+
+		Frustum(const float* matrix)
+		{
+			const auto row = [&](std::size_t r, std::size_t c)
+			{
+				return matrix[(c * 4) + r];
+			};
+
+			// left, right, bottom, top, near, far: the last row plus or minus each of the others
+			for (auto p = 0uz; p < 6; p++)
+			{
+				const auto r = p / 2;
+				const auto sign = (p % 2 == 0) ? 1.0f : -1.0f;
+
+				auto& plane = planes[p];
+
+				for (auto c = 0uz; c < 4; c++)
+				{
+					plane[c] = row(3, c) + (sign * row(r, c));
+				}
+
+				const auto length = std::sqrt((plane[0] * plane[0]) + (plane[1] * plane[1]) + (plane[2] * plane[2]));
+
+				if (length > 0.0f)
+				{
+					for (auto& value : plane)
+					{
+						value /= length;
+					}
+				}
+			}
+		}
+	};
+
+	// boxes kept as separate arrays of min and max per axis, so eight of them are tested against a plane
+	// with a handful of AVX2 instructions. for each plane only the box corner furthest along its normal
+	// matters, and since the normal is the same for all eight boxes the choice between min and max is made
+	// once per plane rather than per box. boxes that merely touch the frustum count as visible
+	class FrustumCuller
+	{
+	private:
+		std::array<std::vector<float>, 3> _min;
+		std::array<std::vector<float>, 3> _max;
+
+	public:
+		// returns the box's index
+		std::size_t add(const Aabb& box)
+		{
+			for (auto a = 0; a < 3; a++)
+			{
+				_min[a].emplace_back(box.min[a]);
+				_max[a].emplace_back(box.max[a]);
+			}
+
+			return size() - 1;
+		}
+
+		// keeps capacity, so a culler refilled every frame stops allocating
+		void clear()
+		{
+			for (auto a = 0; a < 3; a++)
+			{
+				_min[a].clear();
+				_max[a].clear();
+			}
+		}
+
+		std::size_t size() const
+		{
+			return _min[0].size();
+		}
+
+		// appends the indices of the boxes inside or crossing the frustum to visible, in order; returns how many
+		std::size_t cull(const Frustum& frustum, std::vector<std::uint32_t>& visible) const
+		{
+			const auto count = size();
+			const auto before = visible.size();
+
+			auto i = 0uz;
+
+#ifdef GEO_AVX2
+			for (; i < count - (count % 8); i += 8)
+			{
+				auto outside = _mm256_setzero_ps();
+
+				for (const auto& plane : frustum.planes)
+				{
+					const auto corner = [&](int a)
+					{
+						const auto& bound = (plane[a] >= 0.0f) ? _max[a] : _min[a];
+						return _mm256_loadu_ps(bound.data() + i);
+					};
+
+					auto distance = _mm256_set1_ps(plane[3]);
+					distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane[0]), corner(0)));
+					distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane[1]), corner(1)));
+					distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane[2]), corner(2)));
+
+					outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+				}
+
+				auto inside = static_cast<std::uint32_t>(~_mm256_movemask_ps(outside)) & 0xFF;
+
+				while (inside != 0)
+				{
+					visible.emplace_back(static_cast<std::uint32_t>(i + std::countr_zero(inside)));
+					inside &= inside - 1;
+				}
+			}
+#endif
+
+			for (; i < count; i++)
+			{
+				auto inside = true;
+
+				for (const auto& plane : frustum.planes)
+				{
+					auto distance = plane[3];
+
+					for (auto a = 0; a < 3; a++)
+					{
+						distance += plane[a] * ((plane[a] >= 0.0f) ? _max[a][i] : _min[a][i]);
+					}
+
+					inside = inside && distance >= 0.0f;
+				}
+
+				if (inside)
+				{
+					visible.emplace_back(static_cast<std::uint32_t>(i));
+				}
+			}
+
+			return visible.size() - before;
+		}
+	};
+}
+
+#endif
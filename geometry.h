@@ -1,34 +1,133 @@
 #ifndef GEO_GEOMETRY_H
 #define GEO_GEOMETRY_H
 
+#include <array>
+#include <vector>
+
 #include "flux/types.h"
 
+#include "palette.h"
+
 namespace geo
 {
-	struct Vertex
+	enum Face
 	{
-		fx::vec4 pos;
-		fx::vec3 col;
+		CLOSE_FACE = 0,
+		TOP_FACE,
+		LEFT_FACE,
+		RIGHT_FACE,
+		FAR_FACE,
+		BOTTOM_FACE,
 	};
 
-	class Block
+	// two words per vertex, unpacked in world.vertex.glsl:
+	// lo = x:7 | y:7 | z:7 | face:3 | ao:2, hi = block id:16
+	// x/y/z are chunk-local corner coordinates, so block (x, y, z) spans corners x..x+1
+	struct Vertex
 	{
+		std::uint32_t lo;
+		std::uint32_t hi;
+
 	public:
-		fx::vec3 _color;
-		std::vector<Vertex> _vertices;
-		std::vector<GLuint> _indices;
-		std::vector<GLuint> _normals;
+		static constexpr auto POSITION_BITS = 7;
+		static constexpr auto POSITION_MASK = (1u << POSITION_BITS) - 1;
+
+		static constexpr auto MAX_AO = 3u;
 
 	public:
-		Block(const fx::vec3 color)
-			: _color{ color }
+		constexpr std::uint32_t x() const
+		{
+			return lo & POSITION_MASK;
+		}
+
+		constexpr std::uint32_t y() const
+		{
+			return (lo >> POSITION_BITS) & POSITION_MASK;
+		}
+
+		constexpr std::uint32_t z() const
+		{
+			return (lo >> (POSITION_BITS * 2)) & POSITION_MASK;
+		}
+
+		constexpr Face face() const
 		{
-			_vertices = {};
-			_indices = {};
-			_normals = {};
+			return static_cast<Face>((lo >> 21) & 0x7);
+		}
+
+		constexpr std::uint32_t ao() const
+		{
+			return (lo >> 24) & 0x3;
+		}
+
+		constexpr BlockId id() const
+		{
+			return static_cast<BlockId>(hi & 0xFFFF);
+		}
+
+	public:
+		static constexpr Vertex pack(std::uint32_t x, std::uint32_t y, std::uint32_t z, Face face, std::uint32_t ao, BlockId id)
+		{
+			const auto lo = (x & POSITION_MASK) |
+							((y & POSITION_MASK) << POSITION_BITS) |
+							((z & POSITION_MASK) << (POSITION_BITS * 2)) |
+							((static_cast<std::uint32_t>(face) & 0x7) << 21) |
+							((ao & 0x3) << 24);
+
+			return Vertex{ lo, id };
 		}
 	};
 
+	static_assert(sizeof(Vertex) == 8);
+
+	inline const std::array<fx::vec4, 8> cube_vertices
+	{
+		fx::vec4{  1.0f,  1.0f,  1.0f,    1.0f }, // 0 close top right
+		fx::vec4{  1.0f,  1.0f, -1.0f,    1.0f }, // 1 far top right
+		fx::vec4{ -1.0f,  1.0f,  1.0f,    1.0f }, // 2 close top left
+		fx::vec4{ -1.0f,  1.0f, -1.0f,    1.0f }, // 3 far top left
+
+		fx::vec4{  1.0f, -1.0f,  1.0f,    1.0f }, // 4 close bottom right
+		fx::vec4{  1.0f, -1.0f, -1.0f,    1.0f }, // 5 far bottom right
+		fx::vec4{ -1.0f, -1.0f,  1.0f,    1.0f }, // 6 close bottom left
+		fx::vec4{ -1.0f, -1.0f, -1.0f,    1.0f }, // 7 far bottom left
+	};
+
+	// indexed by Face
+	inline const std::array<std::array<GLuint, 6>, 6> face_indices
+	{{
+		{ 0, 2, 6,  6, 4, 0 }, // close
+		{ 3, 2, 0,  0, 1, 3 }, // top
+		{ 3, 7, 6,  6, 2, 3 }, // left
+		{ 0, 4, 5,  5, 1, 0 }, // right
+		{ 1, 5, 7,  7, 3, 1 }, // far
+		{ 6, 7, 5,  5, 4, 6 }, // bottom
+	}};
+
+	// geometry for a whole chunk; blocks themselves carry no mesh data
+	struct Mesh
+	{
+		std::vector<Vertex> vertices;
+		std::vector<GLuint> indices;
+
+		// keeps capacity, so a cleared mesh can be rebuilt without allocating
+		void clear()
+		{
+			vertices.clear();
+			indices.clear();
+		}
+
+		void reserve(std::size_t faces)
+		{
+			vertices.reserve(faces * 4);
+			indices.reserve(faces * 6);
+		}
+
+		std::size_t faces() const
+		{
+			return vertices.size() / 4;
+		}
+	};
 }
 
 #endif
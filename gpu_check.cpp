@@ -0,0 +1,406 @@
+// headless check of the gpu-driven culling path on an offscreen OpenGL 4.6 context, so it runs wherever EGL
+// does, including Mesa's software rasterizer. run it from the repository root, where the shaders are, e.g.
+// g++ -std=c++23 -O2 gpu_check.cpp glad.c -lEGL -ldl -o gpu_check && ./gpu_check
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <iostream>
+#include <print>
+#include <random>
+#include <vector>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "glad.h"
+
+#define PANIC(x) std::println(std::cerr, x); std::exit(EXIT_FAILURE)
+
+#define panic(x) std::print("{} @ {}", x, __FUNCTION__)
+
+#include "flux/float.h"
+#include "flux/vector.h"
+#include "flux/matrix.h"
+#include "flux/types.h"
+
+#include "shader.h"
+#include "buffer.h"
+
+#include "frustum.h"
+#include "mesher.h"
+#include "gpu_cull.h"
+
+namespace
+{
+	// odd at most levels, so the pyramid has to fold its spare rows and columns into the last texels
+	constexpr auto WIDTH = 317, HEIGHT = 179;
+
+	// subchunks per axis around the camera
+	constexpr auto GRID = 5;
+
+	auto gl_errors = 0uz;
+
+	void check(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			std::fprintf(stderr, "FAILED: %s\n", what);
+			std::exit(EXIT_FAILURE);
+		}
+	}
+
+	void GLAPIENTRY report(GLenum, GLenum type, GLuint, GLenum severity, GLsizei, const GLchar* message, const void*)
+	{
+		if (type == GL_DEBUG_TYPE_ERROR || severity == GL_DEBUG_SEVERITY_HIGH)
+		{
+			std::fprintf(stderr, "gl: %s\n", message);
+			gl_errors++;
+		}
+	}
+
+	// a core 4.6 context with no window. mesa's software rasterizer supports everything the culling path
+	// uses but may advertise an older version, so ask it for 4.6 unless the environment already says otherwise
+	void create_context()
+	{
+		setenv("MESA_GL_VERSION_OVERRIDE", "4.6", 0);
+		setenv("MESA_GLSL_VERSION_OVERRIDE", "460", 0);
+
+		const auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+		auto display = (get_platform_display != nullptr) ? get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr) : EGL_NO_DISPLAY;
+
+		if (display == EGL_NO_DISPLAY)
+		{
+			display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		}
+
+		EGLint major = 0, minor = 0;
+		check(eglInitialize(display, &major, &minor) && eglBindAPI(EGL_OPENGL_API), "egl display");
+
+		const EGLint attributes[]
+		{
+			EGL_CONTEXT_MAJOR_VERSION, 4,
+			EGL_CONTEXT_MINOR_VERSION, 6,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+			EGL_NONE,
+		};
+
+		const auto context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, attributes);
+		check(context != EGL_NO_CONTEXT && eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context), "opengl 4.6 core context");
+		check(gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)) != 0, "opengl functions");
+
+		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		glDebugMessageCallback(report, nullptr);
+
+		std::printf("%s, %s\n", reinterpret_cast<const char*>(glGetString(GL_RENDERER)), reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+	}
+
+	// the first draw of every surviving record, sorted so a gpu cull compares with a cpu one regardless of order
+	std::vector<GLuint> first_indices(const std::vector<draw_command>& commands)
+	{
+		std::vector<GLuint> result{};
+
+		for (const auto& command : commands)
+		{
+			result.emplace_back(command.first_index);
+		}
+
+		std::ranges::sort(result);
+		return result;
+	}
+
+	std::vector<std::uint32_t> read_pixels()
+	{
+		std::vector<std::uint32_t> result(WIDTH * HEIGHT);
+		glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, result.data());
+
+		return result;
+	}
+}
+
+int main()
+{
+	create_context();
+
+	auto& types = geo::registry();
+
+	const auto stone = types.add({ "stone", fx::vec3{ 0.45f, 0.45f, 0.48f }, 1.0f, geo::BLOCK_OPAQUE });
+	const auto grass = types.add({ "grass", fx::vec3{ 0.30f, 0.62f, 0.24f }, 1.0f, geo::BLOCK_OPAQUE });
+
+	// a hollow room around the camera, walled by solid subchunks, with scattered blocks beyond the walls.
+	// whichever way the camera faces, the walls hide everything behind them, so occlusion has work to do
+	// and what survives it must still draw the same picture
+	constexpr auto L = geo::Subchunk::CHUNK_LENGTH;
+
+	std::mt19937 random{ 2024 };
+
+	std::vector<geo::Vertex> vertices{};
+	std::vector<GLuint> indices{};
+	std::vector<draw_record> records{};
+	geo::FrustumCuller culler{};
+
+	for (auto x = 0; x < GRID; x++)
+	{
+		for (auto y = 0; y < GRID; y++)
+		{
+			for (auto z = 0; z < GRID; z++)
+			{
+				const auto dx = std::abs(x - (GRID / 2)), dy = std::abs(y - (GRID / 2)), dz = std::abs(z - (GRID / 2));
+				const auto ring = std::max({ dx, dy, dz });
+
+				// the middle of the walls on either side along x is left open
+				if (ring == 0 || (dx == 1 && dy == 0 && dz == 0))
+				{
+					continue;
+				}
+
+				geo::Subchunk subchunk{};
+
+				if (ring == 1)
+				{
+					subchunk.fill(stone);
+				}
+
+				else
+				{
+					for (auto i = 0uz; i < static_cast<std::size_t>(geo::Subchunk::CHUNK_VOLUME); i++)
+					{
+						if (random() % 8 == 0)
+						{
+							subchunk.set(i, grass);
+						}
+					}
+				}
+
+				geo::Mesh mesh{};
+				geo::build_mesh(subchunk, mesh, geo::MeshMode::BINARY);
+
+				// like column_mesh::update in main.cpp: blocks are two units wide and centered on even coordinates
+				const auto bounds = geo::mesh_bounds(mesh);
+				const std::array<float, 3> origin{ 2.0f * L * (x - (GRID / 2)), 2.0f * L * (y - (GRID / 2)), 2.0f * L * (z - (GRID / 2)) };
+
+				geo::Aabb box{};
+
+				for (auto a = 0; a < 3; a++)
+				{
+					box.min[a] = origin[a] + (bounds.min[a] * 2.0f) - 1.0f;
+					box.max[a] = origin[a] + (bounds.max[a] * 2.0f) - 1.0f;
+				}
+
+				culler.add(box);
+
+				records.emplace_back(draw_record
+				{
+					fx::vec4{ box.min[0], box.min[1], box.min[2], 1.0f },
+					fx::vec4{ box.max[0], box.max[1], box.max[2], 1.0f },
+					fx::vec4{ origin[0], origin[1], origin[2], 0.0f },
+					static_cast<GLuint>(mesh.indices.size()),
+					static_cast<GLuint>(indices.size()),
+					static_cast<GLint>(vertices.size()), 0,
+				});
+
+				vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+				indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+			}
+		}
+	}
+
+	GLuint vertex_array = 0;
+	glGenVertexArrays(1, &vertex_array);
+	glBindVertexArray(vertex_array);
+
+	buffer vertex_buffer{ GL_ARRAY_BUFFER, vertices };
+	glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(geo::Vertex), reinterpret_cast<void*>(offsetof(geo::Vertex, lo)));
+	glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(geo::Vertex), reinterpret_cast<void*>(offsetof(geo::Vertex, hi)));
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+
+	buffer index_buffer{ GL_ELEMENT_ARRAY_BUFFER, indices };
+
+	std::vector<fx::vec4> block_colors{};
+
+	for (auto i = 0uz; i < types.size(); i++)
+	{
+		const auto& type = types[static_cast<geo::BlockId>(i)];
+		block_colors.emplace_back(fx::vec4{ type.color[0], type.color[1], type.color[2], type.opacity });
+	}
+
+	buffer block_color_buffer{ GL_SHADER_STORAGE_BUFFER, block_colors };
+	block_color_buffer.base(3);
+
+	geo::ShaderProgram world_program{ "./world" };
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthFunc(GL_LESS);
+
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_BACK);
+
+	glViewport(0, 0, WIDTH, HEIGHT);
+
+	gpu_culler culling{ WIDTH, HEIGHT };
+	culling.records() = records;
+	culling.upload();
+
+	// culls and draws a frame with pv, returning what survived and what it drew. the culler's framebuffer
+	// stays bound, so its depth is there for hidden() afterwards
+	const auto frame = [&](const fx::mat4& pv)
+	{
+		culling.cull(pv);
+		const auto survivors = first_indices(culling.survivors());
+
+		culling.bind();
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		world_program.use();
+		world_program.upload_matrix(pv, "world_pv");
+
+		index_buffer.attach();
+		culling.draw();
+
+		const auto pixels = read_pixels();
+		culling.capture_depth(pv);
+
+		return std::pair{ survivors, pixels };
+	};
+
+	// the first draws the cpu culler lets through, to compare with a gpu cull
+	const auto inside_frustum = [&](const fx::mat4& pv)
+	{
+		std::vector<std::uint32_t> visible{};
+		culler.cull(geo::Frustum{ &pv[0][0] }, visible);
+
+		std::vector<GLuint> result{};
+
+		for (const auto index : visible)
+		{
+			result.emplace_back(records[index].first_index);
+		}
+
+		std::ranges::sort(result);
+		return result;
+	};
+
+	std::vector<fx::vec4> probe_origin(1);
+	buffer probe_origin_buffer{ GL_SHADER_STORAGE_BUFFER, probe_origin };
+
+	GLuint query = 0;
+	glGenQueries(1, &query);
+
+	// whether every record in culled, drawn alone against the depth of the frame just drawn with pv, leaves
+	// no fragment in front of it. a visible record would have, whether or not the frame drew it
+	const auto hidden = [&](const fx::mat4& pv, const std::vector<GLuint>& culled)
+	{
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		glDepthMask(GL_FALSE);
+		glDepthFunc(GL_LEQUAL);
+
+		world_program.use();
+		world_program.upload_matrix(pv, "world_pv");
+		probe_origin_buffer.base(4);
+
+		auto result = true;
+
+		for (const auto& record : records)
+		{
+			if (!std::ranges::binary_search(culled, record.first_index))
+			{
+				continue;
+			}
+
+			probe_origin[0] = record.origin;
+			probe_origin_buffer.update(0, 1);
+
+			GLuint passed = 0;
+			glBeginQuery(GL_ANY_SAMPLES_PASSED, query);
+			glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(record.count), GL_UNSIGNED_INT,
+				reinterpret_cast<void*>(record.first_index * sizeof(GLuint)), record.base_vertex);
+			glEndQuery(GL_ANY_SAMPLES_PASSED);
+			glGetQueryObjectuiv(query, GL_QUERY_RESULT, &passed);
+
+			result = result && (passed == 0);
+		}
+
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glDepthMask(GL_TRUE);
+		glDepthFunc(GL_LESS);
+
+		return result;
+	};
+
+	// the records of inside that are missing from survivors
+	const auto removed = [](const std::vector<GLuint>& inside, const std::vector<GLuint>& survivors)
+	{
+		std::vector<GLuint> result{};
+		std::ranges::set_difference(inside, survivors, std::back_inserter(result));
+
+		return result;
+	};
+
+	// slightly off the middle of the room and off axis, so no box sits exactly on a frustum plane
+	constexpr auto middle = fx::native(L - 1);
+
+	const fx::vec3 eyes[]
+	{
+		fx::vec3{ middle + 3.3f, middle + 1.7f, middle - 2.1f },
+		fx::vec3{ middle - 5.2f, middle - 2.6f, middle + 4.4f },
+	};
+
+	// each view faces a closed wall, then turns to face an open one
+	const fx::vec3 directions[]
+	{
+		fx::vec3{ 0.12f, -0.08f, 0.99f },
+		fx::vec3{ 0.21f, 0.93f, -0.30f },
+	};
+
+	const fx::vec3 turns[]
+	{
+		fx::vec3{ 0.97f, 0.10f, 0.21f },
+		fx::vec3{ -0.90f, 0.20f, 0.38f },
+	};
+
+	for (auto view = 0uz; view < std::size(eyes); view++)
+	{
+		const auto p = fx::perspective(90.0f, fx::native(WIDTH), fx::native(HEIGHT), 1.0f, 10000.0f);
+		const auto pv = fx::multiply(p, fx::lookat(eyes[view], directions[view], fx::vec3{ 0.0f, 1.0f, 0.0f }));
+
+		// without a pyramid the gpu culls by frustum alone, which must agree with the cpu culler
+		culling.discard_depth();
+
+		const auto [inside, full] = frame(pv);
+		check(inside == inside_frustum(pv), "gpu frustum culling matches the cpu culler");
+
+		// the same view again, now tested against the pyramid of the frame just drawn
+		const auto [unoccluded, occluded] = frame(pv);
+		check(std::ranges::includes(inside, unoccluded), "occlusion only removes frustum survivors");
+		check(unoccluded.size() < inside.size(), "the walls occlude something");
+		check(hidden(pv, removed(inside, unoccluded)), "occlusion culling removes only hidden records");
+		check(occluded == full, "occlusion culling leaves the picture unchanged");
+
+		// turning in place changes what is on screen but not what hides what, so culling the turned view
+		// against the pyramid captured before the turn must still draw what frustum culling alone draws
+		const auto turned_pv = fx::multiply(p, fx::lookat(eyes[view], turns[view], fx::vec3{ 0.0f, 1.0f, 0.0f }));
+
+		const auto turned_inside = inside_frustum(turned_pv);
+
+		const auto [turned, turned_pixels] = frame(turned_pv);
+		check(std::ranges::includes(turned_inside, turned), "occlusion after turning only removes frustum survivors");
+		check(hidden(turned_pv, removed(turned_inside, turned)), "occlusion after turning removes only hidden records");
+
+		culling.discard_depth();
+		const auto [_, turned_full] = frame(turned_pv);
+
+		check(turned_pixels == turned_full, "occlusion after turning leaves the picture unchanged");
+
+		std::printf("view %zu: %zu records, %zu inside the frustum on both cpu and gpu, %zu left after occlusion, same %dx%d image; "
+			"turned, %zu of %zu left against the old pyramid, same image\n",
+			view, records.size(), inside.size(), unoccluded.size(), WIDTH, HEIGHT, turned.size(), turned_inside.size());
+	}
+
+	check(gl_errors == 0, "no opengl errors");
+
+	return EXIT_SUCCESS;
+}
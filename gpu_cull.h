@@ -0,0 +1,257 @@
+#ifndef GEO_GPU_CULL_H
+#define GEO_GPU_CULL_H
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <vector>
+
+#include "flux/types.h"
+
+#include "buffer.h"
+#include "shader.h"
+
+// the layout glMultiDrawElementsIndirect reads from the indirect buffer
+struct draw_command
+{
+	GLuint count;
+	GLuint instance_count;
+	GLuint first_index;
+	GLint base_vertex;
+	GLuint base_instance;
+};
+
+// per-subchunk input of the culling compute shader: world bounds, origin and the draw it becomes when visible.
+// laid out for std430, see cull.compute.glsl
+struct draw_record
+{
+	fx::vec4 min;
+	fx::vec4 max;
+	fx::vec4 origin;
+
+	GLuint count;
+	GLuint first_index;
+	GLint base_vertex;
+	GLuint padding;
+};
+
+// the optional gpu-driven path: subchunk records stay on the gpu and a compute shader tests each one against
+// the frustum and against a depth pyramid of the previous frame, appending survivors to the indirect buffer.
+// glMultiDrawElementsIndirectCount then reads the count straight from gpu memory, so visibility never comes
+// back to the cpu. occlusion tests boxes against last frame's depth as seen from last frame's view, so a
+// subchunk coming out from behind an occluder can lag a frame while the camera moves. the world is drawn into
+// the culler's own framebuffer, whose depth texture has a known 32-bit float format the pyramid reads directly
+class gpu_culler
+{
+private:
+	geo::ShaderProgram _cull_program;
+	geo::ShaderProgram _hiz_program;
+
+	const GLsizei _width, _height, _levels;
+	GLuint _framebuffer, _color_buffer, _depth_texture, _hiz_texture;
+	bool _has_depth;
+
+	// the view-projection the pyramid was captured with
+	fx::mat4 _hiz_pv;
+
+private:
+	std::vector<draw_record> _records;
+	buffer<draw_record> _record_buffer;
+
+	// written by the compute shader; the vectors only size the buffers
+	std::vector<draw_command> _commands;
+	buffer<draw_command> _command_buffer;
+
+	std::vector<fx::vec4> _origins;
+	buffer<fx::vec4> _origin_buffer;
+
+	std::vector<GLuint> _count;
+	buffer<GLuint> _count_buffer;
+
+public:
+	// fill, then upload() whenever meshes or their arena offsets change
+	std::vector<draw_record>& records()
+	{
+		return _records;
+	}
+
+	void upload()
+	{
+		if (_records.size() > _commands.size())
+		{
+			_commands.resize(2 * _records.size());
+			_origins.resize(2 * _records.size());
+
+			_command_buffer.bind(GL_DYNAMIC_COPY);
+			_origin_buffer.bind(GL_DYNAMIC_COPY);
+		}
+
+		_record_buffer.bind();
+	}
+
+	void cull(const fx::mat4& pv)
+	{
+		if (_records.empty())
+		{
+			return;
+		}
+
+		_count_buffer.update(0, 1);
+
+		const auto moved = std::memcmp(&pv, &_hiz_pv, sizeof(fx::mat4)) != 0;
+
+		_cull_program.use();
+		_cull_program.upload_matrix(pv, "cull_pv");
+		_cull_program.upload_matrix(_hiz_pv, "hiz_pv");
+		_cull_program.upload_integer(static_cast<GLint>(_records.size()), "cull_records");
+		_cull_program.upload_integer(!_has_depth ? 0 : moved ? 2 : 1, "cull_occlusion");
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, _hiz_texture);
+
+		_origin_buffer.base(4);
+		_record_buffer.base(5);
+		_command_buffer.base(6);
+		_count_buffer.base(7);
+
+		glDispatchCompute(static_cast<GLuint>((_records.size() + 63) / 64), 1, 1);
+		glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+
+	// reads back the commands the last cull() kept. waits for the gpu, so it is for checks rather than frames
+	std::vector<draw_command> survivors() const
+	{
+		glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+		auto count = GLuint{ 0 };
+		_count_buffer.attach();
+		glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &count);
+
+		std::vector<draw_command> result(count);
+		_command_buffer.attach();
+		glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(draw_command) * count, result.data());
+
+		return result;
+	}
+
+	// makes the culler's framebuffer the target and clears its depth; the world and whatever is drawn over it
+	// go there until present()
+	void bind() const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+		glClear(GL_DEPTH_BUFFER_BIT);
+	}
+
+	// copies the finished frame to the default framebuffer and makes that the target again
+	void present() const
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	// with the world program in use and the index arena attached
+	void draw() const
+	{
+		if (_records.empty())
+		{
+			return;
+		}
+
+		_command_buffer.attach(GL_DRAW_INDIRECT_BUFFER);
+		_count_buffer.attach(GL_PARAMETER_BUFFER);
+
+		glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0, static_cast<GLsizei>(_records.size()), 0);
+	}
+
+	// call once the world is drawn into bind()'s framebuffer with pv, before anything else writes depth:
+	// rebuilds the pyramid for the next frame
+	void capture_depth(const fx::mat4& pv)
+	{
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, _depth_texture);
+
+		_hiz_program.use();
+
+		for (auto level = 0; level < _levels; level++)
+		{
+			const auto width = std::max(_width >> level, 1);
+			const auto height = std::max(_height >> level, 1);
+
+			_hiz_program.upload_integer(level, "hiz_level");
+
+			if (level > 0)
+			{
+				glBindImageTexture(0, _hiz_texture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+			}
+
+			glBindImageTexture(1, _hiz_texture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+			glDispatchCompute(static_cast<GLuint>((width + 7) / 8), static_cast<GLuint>((height + 7) / 8), 1);
+			glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		}
+
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+		_hiz_pv = pv;
+		_has_depth = true;
+	}
+
+	// stops occlusion tests until capture_depth() runs again, for when the pyramid no longer matches the world
+	void discard_depth()
+	{
+		_has_depth = false;
+	}
+
+public:
+	gpu_culler(const GLsizei width, const GLsizei height)
+		: _cull_program{ "./cull" }, _hiz_program{ "./hiz" },
+		_width{ width }, _height{ height }, _levels{ static_cast<GLsizei>(std::bit_width(static_cast<unsigned>(std::max(width, height)))) }, _has_depth{ false }, _hiz_pv{},
+		_records{}, _record_buffer{ GL_SHADER_STORAGE_BUFFER, _records },
+		_commands(1024), _command_buffer{ GL_SHADER_STORAGE_BUFFER, _commands },
+		_origins(1024), _origin_buffer{ GL_SHADER_STORAGE_BUFFER, _origins },
+		_count(1, 0), _count_buffer{ GL_SHADER_STORAGE_BUFFER, _count }
+	{
+		glGenTextures(1, &_depth_texture);
+		glBindTexture(GL_TEXTURE_2D, _depth_texture);
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, _width, _height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		glGenTextures(1, &_hiz_texture);
+		glBindTexture(GL_TEXTURE_2D, _hiz_texture);
+		glTexStorage2D(GL_TEXTURE_2D, _levels, GL_R32F, _width, _height);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		glGenRenderbuffers(1, &_color_buffer);
+		glBindRenderbuffer(GL_RENDERBUFFER, _color_buffer);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, _width, _height);
+
+		glGenFramebuffers(1, &_framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _color_buffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, _depth_texture, 0);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			PANIC("Could not complete the culling framebuffer");
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	~gpu_culler()
+	{
+		glDeleteFramebuffers(1, &_framebuffer);
+		glDeleteRenderbuffers(1, &_color_buffer);
+		glDeleteTextures(1, &_depth_texture);
+		glDeleteTextures(1, &_hiz_texture);
+	}
+
+	gpu_culler(const gpu_culler&) = delete;
+	gpu_culler& operator=(const gpu_culler&) = delete;
+};
+
+#endif
@@ -0,0 +1,48 @@
+#version 460 core
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+// level 0 copies the depth buffer; every level after keeps the farthest depth of the texels it covers in
+// the level before, so one texel can stand in for a whole screen rect when testing occlusion
+uniform int hiz_level;
+
+layout (binding = 0) uniform sampler2D hiz_depth;
+
+layout (binding = 0, r32f) readonly uniform image2D hiz_source;
+layout (binding = 1, r32f) writeonly uniform image2D hiz_target;
+
+void main()
+{
+	const ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+	const ivec2 size = imageSize(hiz_target);
+
+	if (any(greaterThanEqual(texel, size)))
+	{
+		return;
+	}
+
+	if (hiz_level == 0)
+	{
+		imageStore(hiz_target, texel, vec4(texelFetch(hiz_depth, texel, 0).r));
+		return;
+	}
+
+	const ivec2 source_size = imageSize(hiz_source);
+	const ivec2 first = texel * 2;
+
+	// odd sizes leave a last row or column in the level before that only the last texel here covers
+	const ivec2 odd = ivec2(equal(texel, size - 1)) * (source_size & 1);
+	const ivec2 last = min(first + 1 + odd, source_size - 1);
+
+	float farthest = 0.0;
+
+	for (int y = first.y; y <= last.y; y++)
+	{
+		for (int x = first.x; x <= last.x; x++)
+		{
+			farthest = max(farthest, imageLoad(hiz_source, ivec2(x, y)).r);
+		}
+	}
+
+	imageStore(hiz_target, texel, vec4(farthest));
+}
@@ -0,0 +1,120 @@
+#ifndef GEO_LAYOUT_H
+#define GEO_LAYOUT_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#define GEO_BMI2 1
+#endif
+
+namespace geo
+{
+	// voxel orderings for a LENGTH^3 cube. index() is the only place a subchunk turns block
+	// coordinates into storage offsets, so swapping the layout reorders every voxel access at once
+
+	// x-major: neighbors along z are adjacent, neighbors along x are LENGTH^2 entries apart
+	template<std::size_t LENGTH>
+	struct XyzLayout
+	{
+		static constexpr std::size_t index(std::size_t x, std::size_t y, std::size_t z)
+		{
+			return (((x * LENGTH) + y) * LENGTH) + z;
+		}
+
+		static constexpr std::array<std::size_t, 3> coords(std::size_t index)
+		{
+			return { index / (LENGTH * LENGTH), (index / LENGTH) % LENGTH, index % LENGTH };
+		}
+	};
+
+	// y-major: horizontal slices are contiguous, which suits column and heightmap walks
+	template<std::size_t LENGTH>
+	struct YzxLayout
+	{
+		static constexpr std::size_t index(std::size_t x, std::size_t y, std::size_t z)
+		{
+			return (((y * LENGTH) + z) * LENGTH) + x;
+		}
+
+		static constexpr std::array<std::size_t, 3> coords(std::size_t index)
+		{
+			return { index % LENGTH, index / (LENGTH * LENGTH), (index / LENGTH) % LENGTH };
+		}
+	};
+
+	namespace detail
+	{
+		inline constexpr std::uint32_t MORTON_X = 0x49249249u;
+		inline constexpr std::uint32_t MORTON_Y = MORTON_X << 1;
+		inline constexpr std::uint32_t MORTON_Z = MORTON_X << 2;
+
+		// spreads the low 10 bits of v so there are two zero bits between each of them
+		constexpr std::uint32_t spread(std::uint32_t v)
+		{
+			v &= 0x3FFu;
+			v = (v | (v << 16)) & 0x030000FFu;
+			v = (v | (v << 8)) & 0x0300F00Fu;
+			v = (v | (v << 4)) & 0x030C30C3u;
+			v = (v | (v << 2)) & 0x09249249u;
+			return v;
+		}
+
+		constexpr std::uint32_t gather(std::uint32_t v)
+		{
+			v &= 0x09249249u;
+			v = (v | (v >> 2)) & 0x030C30C3u;
+			v = (v | (v >> 4)) & 0x0300F00Fu;
+			v = (v | (v >> 8)) & 0x030000FFu;
+			v = (v | (v >> 16)) & 0x000003FFu;
+			return v;
+		}
+	}
+
+	// z-order: bits of x, y and z are interleaved, so every aligned 2^n cube is contiguous
+	// and neighbors along any axis are usually close. uses pdep/pext where BMI2 is available
+	template<std::size_t LENGTH>
+	struct MortonLayout
+	{
+		static_assert(std::has_single_bit(LENGTH) && LENGTH <= 1024, "morton order needs a power-of-two length");
+
+		static constexpr std::size_t index(std::size_t x, std::size_t y, std::size_t z)
+		{
+			const auto ux = static_cast<std::uint32_t>(x);
+			const auto uy = static_cast<std::uint32_t>(y);
+			const auto uz = static_cast<std::uint32_t>(z);
+
+#ifdef GEO_BMI2
+			if !consteval
+			{
+				return _pdep_u32(uz, detail::MORTON_X) | _pdep_u32(uy, detail::MORTON_Y) | _pdep_u32(ux, detail::MORTON_Z);
+			}
+#endif
+
+			return detail::spread(uz) | (detail::spread(uy) << 1) | (detail::spread(ux) << 2);
+		}
+
+		static constexpr std::array<std::size_t, 3> coords(std::size_t index)
+		{
+			const auto i = static_cast<std::uint32_t>(index);
+
+#ifdef GEO_BMI2
+			if !consteval
+			{
+				return { _pext_u32(i, detail::MORTON_Z), _pext_u32(i, detail::MORTON_Y), _pext_u32(i, detail::MORTON_X) };
+			}
+#endif
+
+			return { detail::gather(i >> 2), detail::gather(i >> 1), detail::gather(i) };
+		}
+	};
+
+	// the layout every Subchunk uses unless told otherwise
+	template<std::size_t LENGTH>
+	using DefaultLayout = XyzLayout<LENGTH>;
+}
+
+#endif
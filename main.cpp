@@ -8,6 +8,14 @@
 #include <iostream>
 #include <vector>
 #include <chrono>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <memory>
+#include <optional>
+#include <span>
+#include <thread>
+#include <unordered_map>
 
 //#include <gl/gl.h>
 #include "glad.h"
@@ -53,51 +61,210 @@ wglChoosePixelFormatARB_type* wglChoosePixelFormatARB;
 #include "flux/types.h"
 
 #include "shader.h"
+#include "allocator.h"
+#include "buffer.h"
 
-// let's use attribute string names instead of IDs
-GLuint _attribute_id = 0;
-
+// one large buffer that many meshes are sub-allocated from, so drawing them needs no buffer switches. a copy
+// of the contents is kept on the cpu: allocations upload only their own range, running out of room doubles
+// the buffer and uploads it whole, and compact() moves a bounded amount of data per call to close the holes
+// left by released meshes. allocations can move, so look up offset() each time they are drawn
 template<typename T>
-class buffer
+class gpu_arena
+{
+public:
+	using handle = geo::RangeAllocator::Handle;
+
+private:
+	std::vector<T> _data;
+	buffer<T> _buffer;
+	geo::RangeAllocator _ranges;
+
+public:
+	handle allocate(const std::span<const T> data)
+	{
+		auto result = _ranges.allocate(data.size());
+
+		if (result == geo::RangeAllocator::INVALID)
+		{
+			const auto capacity = std::max(_data.size() * 2, _data.size() + data.size());
+
+			_data.resize(capacity);
+			_ranges.grow(capacity);
+
+			// same buffer name, so attribute pointers into it stay valid
+			_buffer.bind();
+
+			result = _ranges.allocate(data.size());
+		}
+
+		const auto first = _ranges.offset(result);
+
+		std::ranges::copy(data, _data.begin() + first);
+		_buffer.update(first, data.size());
+
+		return result;
+	}
+
+	void release(const handle allocation)
+	{
+		_ranges.release(allocation);
+	}
+
+	// moves up to about budget elements; returns how many moved
+	std::size_t compact(const std::size_t budget)
+	{
+		return _ranges.compact(budget, [&](handle, const std::size_t from, const std::size_t to, const std::size_t count)
+		{
+			std::copy(_data.begin() + from, _data.begin() + from + count, _data.begin() + to);
+			_buffer.update(to, count);
+		});
+	}
+
+	std::size_t offset(const handle allocation) const
+	{
+		return _ranges.offset(allocation);
+	}
+
+	std::size_t size(const handle allocation) const
+	{
+		return _ranges.size(allocation);
+	}
+
+	geo::RangeAllocator::Stats stats() const
+	{
+		return _ranges.stats();
+	}
+
+	void attach() const
+	{
+		_buffer.attach();
+	}
+
+public:
+	gpu_arena(const GLuint type, const std::size_t capacity)
+		: _data(capacity), _buffer{ type, _data }, _ranges{ capacity }
+	{
+	}
+
+	gpu_arena(const gpu_arena&) = delete;
+	gpu_arena& operator=(const gpu_arena&) = delete;
+};
+
+// per-frame data written straight into persistently mapped, coherent memory. the immutable store is split
+// into FRAMES regions of capacity elements and each frame writes the next one, so the cpu fills a region
+// while the gpu still reads the previous ones; a fence per region holds the cpu back only if it laps the gpu
+template<typename T, std::size_t FRAMES = 3>
+class streaming_buffer
 {
+private:
+	static constexpr auto FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
 private:
 	const GLuint _type;
 	GLuint _buffer_id;
 
 private:
-	std::vector<T>& _data;
+	const std::size_t _capacity;
+	T* _mapped;
+
+	std::array<GLsync, FRAMES> _fences;
+	std::size_t _frame;
 
 public:
-	void bind(const GLuint hint = GL_STATIC_DRAW)
+	// the current frame's region, once the gpu has finished reading it
+	std::span<T> region()
+	{
+		auto& fence = _fences[_frame];
+
+		if (fence != nullptr)
+		{
+			while (true)
+			{
+				const auto status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000);
+
+				if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED)
+				{
+					break;
+				}
+			}
+
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+
+		return { _mapped + first(), _capacity };
+	}
+
+	// index of the current region's first element, for draws that read it
+	std::size_t first() const
+	{
+		return _frame * _capacity;
+	}
+
+	// elements per region
+	std::size_t capacity() const
+	{
+		return _capacity;
+	}
+
+	// call once this frame's draws that read the region have been issued
+	void advance()
 	{
-		const auto stride = sizeof(std::remove_reference_t<decltype(_data)>::value_type);
-		const auto size = _data.size();
+		_fences[_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		_frame = (_frame + 1) % FRAMES;
+	}
 
+	void attach() const
+	{
 		glBindBuffer(_type, _buffer_id);
-#pragma message("SUPPORT MORE THAN JUST STATIC DRAW WHEN POSSIBLE!")
-		glBufferData(_type, stride * size, _data.data(), hint);
+	}
+
+	// binds just the current region to an indexed binding point, such as a shader storage block
+	void base(const GLuint binding) const
+	{
+		glBindBufferRange(_type, binding, _buffer_id, sizeof(T) * first(), sizeof(T) * _capacity);
 	}
 
 	void add_attribute(const GLuint element_count, const GLuint element_type, const GLuint stride, const std::size_t offset)
 	{
+		attach();
+
 		std::cout << "attribute id: " << _attribute_id << std::endl;
 		glVertexAttribPointer(_attribute_id, element_count, element_type, GL_FALSE, stride, reinterpret_cast<void*>(offset));
 		glEnableVertexAttribArray(_attribute_id);
 		_attribute_id++;
 	}
 
-	void base()
+public:
+	streaming_buffer(const GLuint type, const std::size_t capacity)
+		: _type{ type }, _capacity{ capacity }, _fences{}, _frame{ 0 }
 	{
-		glBindBufferBase(_type, _attribute_id, _buffer_id);
+		const auto size = static_cast<GLsizeiptr>(sizeof(T) * capacity * FRAMES);
+
+		glGenBuffers(1, &_buffer_id);
+		glBindBuffer(_type, _buffer_id);
+		glBufferStorage(_type, size, nullptr, FLAGS);
+
+		_mapped = static_cast<T*>(glMapBufferRange(_type, 0, size, FLAGS));
 	}
 
-public:
-	buffer(const GLuint type, std::vector<T>& data)
-		: _type{ type }, _data{ data }
+	~streaming_buffer()
 	{
-		glGenBuffers(1, &_buffer_id);
-		bind();
+		for (const auto fence : _fences)
+		{
+			if (fence != nullptr)
+			{
+				glDeleteSync(fence);
+			}
+		}
+
+		glBindBuffer(_type, _buffer_id);
+		glUnmapBuffer(_type);
+		glDeleteBuffers(1, &_buffer_id);
 	}
+
+	streaming_buffer(const streaming_buffer&) = delete;
+	streaming_buffer& operator=(const streaming_buffer&) = delete;
 };
 
 
@@ -384,56 +551,114 @@ public:
 
 
 #include "geometry.h"
-
-class Subchunk
+#include "block.h"
+#include "chunk.h"
+#include "frustum.h"
+#include "mesher.h"
+#include "mesh_cache.h"
+#include "mesh_service.h"
+#include "world.h"
+
+#include "gpu_cull.h"
+
+// an uploaded mesh: its own ranges of the shared vertex and index arenas, so remeshing a subchunk
+// re-uploads that subchunk alone. subchunks whose meshes share a content key share one of these.
+// indices stay relative to the mesh's first vertex and are drawn with it as the base vertex
+struct gpu_mesh
 {
-public:
-	static constexpr auto CHUNK_LENGTH = 16;
+	gpu_arena<geo::Vertex>& vertex_arena;
+	gpu_arena<GLuint>& index_arena;
 
-private:
-	std::array<std::array<std::array<geo::Block*, CHUNK_LENGTH>, CHUNK_LENGTH>, CHUNK_LENGTH> _blocks;
+	gpu_arena<geo::Vertex>::handle vertices;
+	gpu_arena<GLuint>::handle indices;
 
-public:
-	constexpr auto& operator[](std::size_t x)
-	{
-		return _blocks[x];
-	}
+	// in corner units local to the subchunk
+	geo::Aabb bounds;
 
-	constexpr const auto& operator[](std::size_t x) const
+	gpu_mesh(gpu_arena<geo::Vertex>& vertex_arena, gpu_arena<GLuint>& index_arena, const geo::Mesh& mesh)
+		: vertex_arena{ vertex_arena }, index_arena{ index_arena },
+		vertices{ vertex_arena.allocate(mesh.vertices) }, indices{ index_arena.allocate(mesh.indices) }, bounds{ geo::mesh_bounds(mesh) }
 	{
-		return _blocks[x];
 	}
 
-public:
-	Subchunk()
+	~gpu_mesh()
 	{
-		_blocks = {};
+		vertex_arena.release(vertices);
+		index_arena.release(indices);
 	}
+
+	gpu_mesh(const gpu_mesh&) = delete;
+	gpu_mesh& operator=(const gpu_mesh&) = delete;
 };
 
-class Chunk
+// the commands and per-draw origins of one frame's world pass, rebuilt every frame. both are streamed, and
+// the shader finds a draw's origin at gl_DrawID. they are replaced with larger ones when the world outgrows them
+struct draw_list
 {
-public:
-	static constexpr auto CHUNK_HEIGHT = 1;
+	// keeps each region's offset a multiple of any storage buffer offset alignment up to 1 KiB
+	static constexpr auto GRANULARITY = 64uz;
 
-private:
-	std::array<Subchunk, CHUNK_HEIGHT> _subchunks;
+	streaming_buffer<draw_command> commands;
+	streaming_buffer<fx::vec4> origins;
 
-public:
-	constexpr auto& operator[](std::size_t x)
+	draw_list(const std::size_t capacity)
+		: commands{ GL_DRAW_INDIRECT_BUFFER, capacity }, origins{ GL_SHADER_STORAGE_BUFFER, capacity }
 	{
-		return _subchunks[x];
 	}
+};
 
-	constexpr const auto& operator[](std::size_t x) const
-	{
-		return _subchunks[x];
-	}
+// what gets drawn for one subchunk, if anything
+struct subchunk_mesh
+{
+	std::shared_ptr<gpu_mesh> gpu;
+	std::uint64_t version;
 
-public:
-	Chunk()
+	// in world space
+	geo::Aabb bounds;
+};
+
+// vertex positions are local to the subchunk, whose blocks are two units wide
+fx::vec3 subchunk_origin(const geo::ChunkCoord& coord)
+{
+	constexpr auto span = 2.0f * geo::Subchunk::CHUNK_LENGTH;
+	return fx::vec3{ coord.x * span, coord.y * span, coord.z * span };
+}
+
+// the meshes of one column of subchunks with bounds around all of them, so the frustum can reject a whole
+// column before any of its subchunks are tested
+struct column_mesh
+{
+	std::array<subchunk_mesh, geo::Chunk::CHUNK_HEIGHT> subchunks;
+	std::size_t meshes;
+	geo::Aabb bounds;
+
+	// refreshes the bounds after subchunk meshes change; coord is the column's, in chunk units
+	void update(const geo::ChunkCoord& coord)
 	{
-		_subchunks = {};
+		meshes = 0;
+		bounds = geo::Aabb::none();
+
+		for (auto i = 0uz; i < subchunks.size(); i++)
+		{
+			auto& subchunk = subchunks[i];
+
+			if (subchunk.gpu == nullptr)
+			{
+				continue;
+			}
+
+			// blocks are centered on the even coordinates their corners straddle
+			const auto origin = subchunk_origin(geo::Chunk::subchunk_coord(coord, i));
+
+			for (auto a = 0; a < 3; a++)
+			{
+				subchunk.bounds.min[a] = origin[a] + (subchunk.gpu->bounds.min[a] * 2.0f) - 1.0f;
+				subchunk.bounds.max[a] = origin[a] + (subchunk.gpu->bounds.max[a] * 2.0f) - 1.0f;
+			}
+
+			bounds.extend(subchunk.bounds);
+			meshes++;
+		}
 	}
 };
 
@@ -476,28 +701,6 @@ int APIENTRY wWinMain(_In_     HINSTANCE instance,
 	geo::ShaderProgram sky_program{ "./sky" };
 
 
-	Chunk* c = new Chunk{};
-
-	for (auto s = 0; s < 16; s++)
-	{
-		for (auto i = 0; i < 16; i++)
-		{
-			for (auto j = 0; j < 16; j++)
-			{
-				for (auto k = 0; k < 16; k++)
-				{
-					// TODO: chunk rendering here
-				}
-			}
-		}
-	}
-	
-	
-
-
-
-	
-
 	static std::vector<fx::vec4> verts
 	{
 		{ -1.0f, -1.0f, -1.0f, 1.0f, },
@@ -543,46 +746,25 @@ int APIENTRY wWinMain(_In_     HINSTANCE instance,
 		std::swap(verts[i], verts[i + 2]);
 	}
 
-	static std::vector<fx::vec4> cube_vertices
-	{
-		{  1.0f,  1.0f,  1.0f,    1.0f }, // 0 close top right
-		{  1.0f,  1.0f, -1.0f,    1.0f }, // 1 far top right
-		{ -1.0f,  1.0f,  1.0f,    1.0f }, // 2 close top left
-		{ -1.0f,  1.0f, -1.0f,    1.0f }, // 3 far top left
-							      
-		{  1.0f, -1.0f,  1.0f,    1.0f }, // 4 close bottom right
-		{  1.0f, -1.0f, -1.0f,    1.0f }, // 5 far bottom right
-		{ -1.0f, -1.0f,  1.0f,    1.0f }, // 6 close bottom left
-		{ -1.0f, -1.0f, -1.0f,    1.0f }, // 7 far bottom left
-	};
+	auto& types = geo::registry();
 
-	static std::vector<GLuint> close_face{ 0, 2, 6,  6, 4, 0 }, // normal 0
-							     top_face{ 3, 2, 0,  0, 1, 3 }, // normal 1
-							    left_face{ 3, 7, 6,  6, 2, 3 }, // normal 2
-							   right_face{ 0, 4, 5,  5, 1, 0 }, // normal 3
-							     far_face{ 1, 5, 7,  7, 3, 1 }, // normal 4
-							  bottom_face{ 6, 7, 5,  5, 4, 6 }; // normal 5
-
-	enum
-	{
-		CLOSE_FACE = 0,
-		TOP_FACE,
-		LEFT_FACE,
-		RIGHT_FACE,
-		FAR_FACE,
-		BOTTOM_FACE,
-	};
+	const auto stone = types.add({ "stone", fx::vec3{ 0.45f, 0.45f, 0.48f }, 1.0f, geo::BLOCK_OPAQUE });
+	const auto dirt  = types.add({ "dirt",  fx::vec3{ 0.47f, 0.33f, 0.20f }, 1.0f, geo::BLOCK_OPAQUE });
+	const auto grass = types.add({ "grass", fx::vec3{ 0.30f, 0.62f, 0.24f }, 1.0f, geo::BLOCK_OPAQUE });
 
-	auto subchunk = Subchunk{};
+	geo::World world{};
 
-	constexpr auto whole = fx::native(Subchunk::CHUNK_LENGTH);
+	const auto origin = geo::ChunkCoord{ 0, 0, 0 };
+	auto& subchunk = world.load(origin)[0];
+
+	constexpr auto whole = fx::native(geo::Subchunk::CHUNK_LENGTH);
 	constexpr auto half = whole / 2;
 
-	for (auto x = 0; x < Subchunk::CHUNK_LENGTH; x++)
+	for (auto x = 0; x < geo::Subchunk::CHUNK_LENGTH; x++)
 	{
-		for (auto y = 0; y < Subchunk::CHUNK_LENGTH; y++)
+		for (auto y = 0; y < geo::Subchunk::CHUNK_LENGTH; y++)
 		{
-			for (auto z = 0; z < Subchunk::CHUNK_LENGTH; z++)
+			for (auto z = 0; z < geo::Subchunk::CHUNK_LENGTH; z++)
 			{
 				const auto xyz = fx::vec3{ x, y, z };
 				const auto center = fx::broadcast<3>(half);
@@ -591,209 +773,195 @@ int APIENTRY wWinMain(_In_     HINSTANCE instance,
 
 				if (distance < half)
 				{
-					const auto result = fx::scale(xyz, whole);
-					subchunk[x][y][z] = new geo::Block{ result };
+					const auto type = (y < 6) ? stone : (y < 10) ? dirt : grass;
+					subchunk.set(x, y, z, type);
 				}
 			}
 		}
 	}
 
-	std::size_t stride_accumulator = 0;
-
-	for (auto x = 0; x < Subchunk::CHUNK_LENGTH; x++)
+	// the whole column starts out dirty, so the first frame meshes it
+	for (auto i = 0uz; i < geo::Chunk::CHUNK_HEIGHT; i++)
 	{
-		for (auto y = 0; y < Subchunk::CHUNK_LENGTH; y++)
-		{
-			for (auto z = 0; z < Subchunk::CHUNK_LENGTH; z++)
-			{
-				auto b = subchunk[x][y][z];
+		world.mark_dirty(geo::Chunk::subchunk_coord(origin, i));
+	}
 
-				const auto xyz = fx::vec3{ x, y, z };
-				const auto doubled = fx::scale(xyz, 2.0f);
+	// press G to cycle through the naive, greedy and binary meshers
+	auto mesh_mode = geo::MeshMode::BINARY;
+	auto mesh_toggle_held = false;
 
-				if (b != nullptr)
-				{
-					for (auto i = 0; i < cube_vertices.size(); i++)
-					{
-						const auto m = fx::translation(doubled);
+	// press X to carve a box of air in front of the camera, C to fill one with stone
+	auto edit_held = false;
 
-						geo::Vertex v{};
+	// press I to print the meshing and gpu arena counters; edits themselves stay quiet
+	auto stats_held = false;
+	auto remeshed = 0uz, remeshed_immediately = 0uz;
 
-						v.pos = fx::apply(m, cube_vertices[i]);
+	static constexpr auto stride = sizeof(geo::Vertex);
 
-						const auto sum = fx::add(cube_vertices[i], fx::broadcast(1.0f));
-						const auto quotient = fx::truncate<4, 3>(fx::scale(sum, 1 / 2.0f));
-						const auto total = fx::add(xyz, quotient);
-						
-						v.col = fx::scale(total, 1 / whole);
+	// every subchunk mesh lives in these two buffers, which start at a few MiB and double as needed.
+	// declared before the meshes so they outlive the ranges those hold
+	gpu_arena<geo::Vertex> vertex_arena{ GL_ARRAY_BUFFER, 1 << 20 };
+	gpu_arena<GLuint> index_arena{ GL_ELEMENT_ARRAY_BUFFER, 3 << 19 };
 
-						/*v.col = geo::vec3
-						{
-							(x + ((cube_vertices[i].x + 1.0f) / 2.0f)) / static_cast<float>(subchunk::CHUNK_LENGTH),
-							(y + ((cube_vertices[i].y + 1.0f) / 2.0f)) / static_cast<float>(subchunk::CHUNK_LENGTH),
-							(z + ((cube_vertices[i].z + 1.0f) / 2.0f)) / static_cast<float>(subchunk::CHUNK_LENGTH),
-						};*/
+	// arena compaction moves at most this many vertices and indices per frame, once enough free space is scattered
+	static constexpr auto COMPACTION_BUDGET = 1uz << 16;
+	static constexpr auto COMPACTION_THRESHOLD = 0.25f;
 
-						b->_vertices.emplace_back(v);
-					}
+	// keyed by column, in chunk units like the world
+	std::unordered_map<geo::ChunkCoord, column_mesh, geo::ChunkCoordHash> column_meshes{};
 
-					if (y + 1 < Subchunk::CHUNK_LENGTH)
-					{
-						if (subchunk[x][y + 1][z] == nullptr)
-						{
-							b->_indices.append_range(top_face);
-							b->_normals.emplace_back(TOP_FACE);
-						}
-					}
+	// every live upload by content key, so identical subchunks draw from the same buffers
+	std::unordered_map<geo::MeshKey, std::weak_ptr<gpu_mesh>, geo::MeshKeyHash> uploaded_meshes{};
 
-					else if (y == Subchunk::CHUNK_LENGTH - 1)
-					{
-						b->_indices.append_range(top_face);
-						b->_normals.emplace_back(TOP_FACE);
-					}
+	// every subchunk goes out in one multi-draw, so the number of draw calls stays at one as the world grows
+	auto draws = std::make_unique<draw_list>(1024);
 
+	// columns are culled against the view first and then the subchunks of the columns that survive.
+	// the lists map culler indices back to what was added and are refilled every frame
+	geo::FrustumCuller column_culler{};
+	geo::FrustumCuller subchunk_culler{};
 
-					if (y - 1 > 0)
-					{
-						if (subchunk[x][y - 1][z] == nullptr)
-						{
-							b->_indices.append_range(bottom_face);
-							b->_normals.emplace_back(BOTTOM_FACE);
-						}
-					}
+	std::vector<std::pair<geo::ChunkCoord, const column_mesh*>> culled_columns{};
+	std::vector<std::pair<geo::ChunkCoord, const subchunk_mesh*>> culled_subchunks{};
+	std::vector<std::uint32_t> visible{};
 
-					else if (y == 0)
-					{
-						b->_indices.append_range(bottom_face);
-						b->_normals.emplace_back(BOTTOM_FACE);
-					}
+	// subchunk meshes drawn and culled last frame
+	auto drawn = 0uz, culled = 0uz;
 
+	// press V to switch culling to the gpu and back. its records are rebuilt whenever meshes change or move.
+	// made on the first press, so the depth pyramid and its buffers cost nothing until then
+	std::optional<gpu_culler> gpu_culling{};
 
-					if (x + 1 < Subchunk::CHUNK_LENGTH)
-					{
-						if (subchunk[x + 1][y][z] == nullptr)
-						{
-							b->_indices.append_range(right_face);
-							b->_normals.emplace_back(RIGHT_FACE);
-						}
-					}
+	auto gpu_cull = false;
+	auto gpu_cull_held = false;
+	auto records_dirty = true;
 
-					else if (x == Subchunk::CHUNK_LENGTH - 1)
-					{
-						b->_indices.append_range(right_face);
-						b->_normals.emplace_back(RIGHT_FACE);
-					}
+	// the world shader's two integer attributes sit at locations 0 and 1 and always read the vertex arena,
+	// so the next attribute goes after them
+	vertex_arena.attach();
+	glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, stride, reinterpret_cast<void*>(offsetof(geo::Vertex, lo)));
+	glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, stride, reinterpret_cast<void*>(offsetof(geo::Vertex, hi)));
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	_attribute_id = 2;
 
+	// vertices only carry a block id, so colors are looked up per type in world.vertex.glsl
+	std::vector<fx::vec4> block_colors{};
 
-					if (x - 1 > 0)
-					{
-						if (subchunk[x - 1][y][z] == nullptr)
-						{
-							b->_indices.append_range(left_face);
-							b->_normals.emplace_back(LEFT_FACE);
-						}
-					}
+	for (auto i = 0uz; i < types.size(); i++)
+	{
+		const auto& type = types[static_cast<geo::BlockId>(i)];
+		block_colors.emplace_back(fx::vec4{ type.color[0], type.color[1], type.color[2], type.opacity });
+	}
 
-					else if (x == 0)
-					{
-						b->_indices.append_range(left_face);
-						b->_normals.emplace_back(LEFT_FACE);
-					}
+	buffer block_color_buffer{ GL_SHADER_STORAGE_BUFFER, block_colors };
+	block_color_buffer.base(3);
 
+	// small batches of dirty subchunks, like the few an edit touches, are meshed right away on this thread
+	// so the edit shows up in the same frame; bigger batches such as a mode switch go to the workers
+	static constexpr auto IMMEDIATE_REMESHES = 16uz;
 
-					if (z + 1 < Subchunk::CHUNK_LENGTH)
-					{
-						if (subchunk[x][y][z + 1] == nullptr)
-						{
-							b->_indices.append_range(close_face);
-							b->_normals.emplace_back(CLOSE_FACE);
-						}
-					}
+	// the engine's one job system: a worker per core, leaving a core for this thread
+	geo::Scheduler scheduler{ std::max(std::thread::hardware_concurrency(), 2u) - 1 };
 
-					else if (z == Subchunk::CHUNK_LENGTH - 1)
-					{
-						b->_indices.append_range(close_face);
-						b->_normals.emplace_back(CLOSE_FACE);
-					}
+	// both the frame thread and the workers mesh through the cache, so identical subchunks are meshed once
+	geo::MeshCache mesh_cache{};
+	geo::MeshService mesh_service{ scheduler, &mesh_cache };
+	std::uint64_t mesh_version = 0;
 
+	geo::Mesh immediate_mesh{};
 
-					if (z - 1 > 0)
-					{
-						if (subchunk[x][y][z - 1] == nullptr)
-						{
-							b->_indices.append_range(far_face);
-							b->_normals.emplace_back(FAR_FACE);
-						}
-					}
+	// the gpu copy of a finished mesh, uploading it unless the same content key is already on the gpu
+	auto share = [&](const geo::Mesh& mesh, const geo::MeshKey& key) -> std::shared_ptr<gpu_mesh>
+	{
+		// buried and empty subchunks never get buffers
+		if (mesh.indices.empty())
+		{
+			return nullptr;
+		}
 
-					else if (z == 0)
-					{
-						b->_indices.append_range(far_face);
-						b->_normals.emplace_back(FAR_FACE);
-					}
+		if (key.hash != 0)
+		{
+			if (auto shared = uploaded_meshes[key].lock())
+			{
+				return shared;
+			}
+		}
 
+		auto result = std::make_shared<gpu_mesh>(vertex_arena, index_arena, mesh);
 
-					for (auto& i : b->_indices)
-					{
-						i += static_cast<GLuint>(stride_accumulator);
-					}
+		if (key.hash != 0)
+		{
+			uploaded_meshes[key] = result;
+		}
 
-					stride_accumulator += b->_vertices.size();
-				}
-			}
+		if (uploaded_meshes.size() > (2 * column_meshes.size() * geo::Chunk::CHUNK_HEIGHT) + 64)
+		{
+			std::erase_if(uploaded_meshes, [](const auto& upload) { return upload.second.expired(); });
 		}
-	}
 
-	std::vector<geo::Vertex> world_vertices;
-	std::vector<GLuint> world_indices;
-	std::vector<GLuint> world_normals;
+		return result;
+	};
 
-	for (auto x = 0; x < Subchunk::CHUNK_LENGTH; x++)
+	// points a subchunk at its finished mesh; versions keep a slow worker from overwriting a newer mesh built on this thread
+	auto upload = [&](const geo::ChunkCoord& coord, geo::Mesh& mesh, const geo::MeshKey& key, const std::uint64_t version)
 	{
-		for (auto y = 0; y < Subchunk::CHUNK_LENGTH; y++)
+		const auto column_coord = geo::Chunk::column_coord(coord);
+
+		auto& column = column_meshes[column_coord];
+		auto& entry = column.subchunks[geo::Chunk::subchunk_index(coord)];
+
+		if (entry.version > version)
 		{
-			for (auto z = 0; z < Subchunk::CHUNK_LENGTH; z++)
-			{
-				auto b = subchunk[x][y][z];
+			return;
+		}
 
-				if (b != nullptr)
-				{
-					for (auto& v : b->_vertices)
-					{
-						world_vertices.emplace_back(v);
-					}
+		entry.version = version;
+		entry.gpu = share(mesh, key);
 
-					for (auto& i : b->_indices)
-					{
-						world_indices.emplace_back(i);
-					}
+		column.update(column_coord);
+		records_dirty = true;
+	};
 
-					for (auto& n : b->_normals)
-					{
-						world_normals.emplace_back(n);
-					}
-				}
-			}
+	auto remesh = [&](const geo::ChunkCoord& coord, const bool immediate)
+	{
+		const auto source = world.subchunk(coord);
+
+		// the whole column was unloaded
+		if (source == nullptr)
+		{
+			column_meshes.erase(geo::Chunk::column_coord(coord));
+			records_dirty = true;
+			return;
 		}
 
-	}
+		const auto neighbors = world.neighbors(geo::Chunk::column_coord(coord), geo::Chunk::subchunk_index(coord));
 
-	std::vector<geo::Vertex> world_vertices_transform = world_vertices;
+		if (immediate)
+		{
+			immediate_mesh.clear();
+			const auto key = geo::build_mesh(mesh_cache, *source, immediate_mesh, mesh_mode, neighbors);
+			upload(coord, immediate_mesh, key, ++mesh_version);
+			return;
+		}
 
-	static constexpr auto stride = sizeof(geo::Vertex);
+		geo::MeshJob job{ coord, ++mesh_version, mesh_mode, *source, {} };
 
-	buffer world_vertex_buffer{ GL_ARRAY_BUFFER, world_vertices_transform };
-	world_vertex_buffer.add_attribute(4, GL_FLOAT, stride, offsetof(geo::Vertex, pos));
-	world_vertex_buffer.add_attribute(3, GL_FLOAT, stride, offsetof(geo::Vertex, col));
-	
-	buffer world_normal_buffer{ GL_SHADER_STORAGE_BUFFER, world_normals };
-	world_normal_buffer.base();
+		for (auto i = 0uz; i < neighbors.size(); i++)
+		{
+			if (neighbors[i] != nullptr)
+			{
+				job.neighbors[i] = *neighbors[i];
+			}
+		}
 
-	buffer world_index_buffer{ GL_ELEMENT_ARRAY_BUFFER, world_indices };
+		mesh_service.submit(std::move(job));
+	};
 
 
 	std::vector<fx::vec4> skybox(verts.size());
-	buffer sky_vertex_buffer{ GL_ARRAY_BUFFER, skybox };
+	streaming_buffer<fx::vec4> sky_vertex_buffer{ GL_ARRAY_BUFFER, skybox.size() };
 	sky_vertex_buffer.add_attribute(4, GL_FLOAT, sizeof(fx::vec4), NULL);
 
 	glEnable(GL_DEPTH_TEST);
@@ -826,10 +994,6 @@ int APIENTRY wWinMain(_In_     HINSTANCE instance,
 	// let's make sure our timer stuff fires initially
 	auto timer = 0.0f; 
 
-	
-	world_index_buffer.bind();
-	world_normal_buffer.bind();
-
 	auto last_time = std::chrono::high_resolution_clock::now();
 	auto last_update = last_time;
 
@@ -855,7 +1019,8 @@ int APIENTRY wWinMain(_In_     HINSTANCE instance,
 		if (timer > 1.0)
 		{
 			const auto fps = static_cast<int>(1.0f / delta_time);
-			const auto title = std::format(L"geo - {} FPS", fps);
+			const auto title = gpu_cull ? std::format(L"geo - {} FPS - {} subchunk candidates culled on the gpu", fps, gpu_culling->records().size())
+				: std::format(L"geo - {} FPS - {} subchunks drawn, {} culled", fps, drawn, culled);
 			SetWindowText(_window.hwnd(), title.c_str());
 			last_update = current_time;
 		}
@@ -869,6 +1034,123 @@ int APIENTRY wWinMain(_In_     HINSTANCE instance,
 		_window.key_action(VK_SPACE,       [&]() { fx::add(camera.vel(), fx::scale(camera.up(), (CAMERA_SPEED * delta_time))); });
 		_window.key_action(VK_LSHIFT,      [&]() { fx::add(camera.vel(), fx::scale(camera.up(), (CAMERA_SPEED * delta_time))); });
 		
+		const auto mesh_toggle = window::key_pressed(VkKeyScan('g'));
+
+		if (mesh_toggle && !mesh_toggle_held)
+		{
+			switch (mesh_mode)
+			{
+			case geo::MeshMode::NAIVE:  mesh_mode = geo::MeshMode::GREEDY; break;
+			case geo::MeshMode::GREEDY: mesh_mode = geo::MeshMode::BINARY; break;
+			case geo::MeshMode::BINARY: mesh_mode = geo::MeshMode::NAIVE;  break;
+			}
+
+			for (const auto& [coord, chunk] : world)
+			{
+				for (auto i = 0uz; i < geo::Chunk::CHUNK_HEIGHT; i++)
+				{
+					world.mark_dirty(geo::Chunk::subchunk_coord(coord, i));
+				}
+			}
+		}
+
+		mesh_toggle_held = mesh_toggle;
+
+		const auto cull_toggle = window::key_pressed(VkKeyScan('v'));
+
+		if (cull_toggle && !gpu_cull_held)
+		{
+			gpu_cull = !gpu_cull;
+			records_dirty = true;
+
+			if (!gpu_culling)
+			{
+				gpu_culling.emplace(WIDTH, HEIGHT);
+			}
+
+			else
+			{
+				gpu_culling->discard_depth();
+			}
+		}
+
+		gpu_cull_held = cull_toggle;
+
+		const auto carve = window::key_pressed(VkKeyScan('x'));
+		const auto build = window::key_pressed(VkKeyScan('c'));
+
+		if ((carve || build) && !edit_held)
+		{
+			// the camera looks down -dir; blocks are two units wide and centered on even coordinates
+			const auto target = fx::add(camera.pos(), fx::scale(camera.dir(), -8.0f));
+
+			std::array<int, 3> center{};
+
+			for (auto a = 0; a < 3; a++)
+			{
+				center[a] = static_cast<int>(std::floor((target[a] + 1.0f) / 2.0f));
+			}
+
+			world.fill({ center[0] - 1, center[1] - 1, center[2] - 1 }, { center[0] + 1, center[1] + 1, center[2] + 1 }, carve ? geo::AIR : stone);
+
+			// carving can open a view through what the pyramid still records as solid
+			if (gpu_culling)
+			{
+				gpu_culling->discard_depth();
+			}
+		}
+
+		edit_held = carve || build;
+
+		if (world.dirty() > 0)
+		{
+			const auto dirty = world.take_dirty();
+			const auto immediate = dirty.size() <= IMMEDIATE_REMESHES;
+
+			for (const auto& coord : dirty)
+			{
+				remesh(coord, immediate);
+			}
+
+			remeshed += dirty.size();
+			remeshed_immediately += immediate ? dirty.size() : 0;
+		}
+
+		const auto stats_toggle = window::key_pressed(VkKeyScan('i'));
+
+		if (stats_toggle && !stats_held)
+		{
+			const auto cached = mesh_cache.stats();
+
+			std::println("{} mesher: {} subchunks remeshed, {} of them on this thread; mesh cache {} hits, {} misses, {} KiB",
+				geo::mesh_mode_name(mesh_mode), remeshed, remeshed_immediately, cached.hits, cached.misses, mesh_cache.memory() / 1024);
+
+			const auto vertices = vertex_arena.stats();
+			const auto indices = index_arena.stats();
+
+			std::println("gpu arenas: vertices {}/{} KiB in {} holes, {:.0f}% fragmented; indices {}/{} KiB in {} holes, {:.0f}% fragmented",
+				vertices.used * sizeof(geo::Vertex) / 1024, vertices.capacity * sizeof(geo::Vertex) / 1024, vertices.holes, vertices.fragmentation() * 100.0f,
+				indices.used * sizeof(GLuint) / 1024, indices.capacity * sizeof(GLuint) / 1024, indices.holes, indices.fragmentation() * 100.0f);
+		}
+
+		stats_held = stats_toggle;
+
+		mesh_service.poll([&](geo::MeshResult& result)
+		{
+			upload(result.coord, result.mesh, result.key, result.version);
+		});
+
+		// released meshes leave holes; close them a little each frame instead of stalling on one big move
+		if (vertex_arena.stats().fragmentation() > COMPACTION_THRESHOLD && vertex_arena.compact(COMPACTION_BUDGET) > 0)
+		{
+			records_dirty = true;
+		}
+
+		if (index_arena.stats().fragmentation() > COMPACTION_THRESHOLD && index_arena.compact(COMPACTION_BUDGET) > 0)
+		{
+			records_dirty = true;
+		}
+
 		if (window::key_pressed(VK_MBUTTON))
 		{
 			fov = 60.0f;
@@ -888,15 +1170,141 @@ int APIENTRY wWinMain(_In_     HINSTANCE instance,
 
 		glClear(GL_DEPTH_BUFFER_BIT);
 
-		world_program.use();
-		world_vertex_buffer.bind(GL_DYNAMIC_DRAW);
-
-		for (auto i = 0; i < world_vertices.size(); i++)
+		if (gpu_cull)
 		{
-			world_vertices_transform[i].pos = fx::apply(pv, world_vertices[i].pos);
+			if (records_dirty)
+			{
+				auto& records = gpu_culling->records();
+				records.clear();
+
+				for (const auto& [coord, column] : column_meshes)
+				{
+					for (auto i = 0uz; i < column.subchunks.size(); i++)
+					{
+						const auto& subchunk = column.subchunks[i];
+
+						if (subchunk.gpu == nullptr)
+						{
+							continue;
+						}
+
+						const auto& [min, max] = subchunk.bounds;
+						const auto origin = subchunk_origin(geo::Chunk::subchunk_coord(coord, i));
+
+						records.emplace_back(draw_record
+						{
+							fx::vec4{ min[0], min[1], min[2], 1.0f },
+							fx::vec4{ max[0], max[1], max[2], 1.0f },
+							fx::vec4{ origin[0], origin[1], origin[2], 0.0f },
+							static_cast<GLuint>(index_arena.size(subchunk.gpu->indices)),
+							static_cast<GLuint>(index_arena.offset(subchunk.gpu->indices)),
+							static_cast<GLint>(vertex_arena.offset(subchunk.gpu->vertices)), 0,
+						});
+					}
+				}
+
+				gpu_culling->upload();
+				records_dirty = false;
+			}
+
+			gpu_culling->cull(pv);
+			gpu_culling->bind();
+
+			world_program.use();
+			world_program.upload_matrix(pv, "world_pv");
+
+			index_arena.attach();
+			gpu_culling->draw();
+			gpu_culling->capture_depth(pv);
 		}
 
-		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(world_indices.size()), GL_UNSIGNED_INT, nullptr);
+		else
+		{
+			const geo::Frustum frustum{ &pv[0][0] };
+
+			column_culler.clear();
+			culled_columns.clear();
+
+			auto meshes = 0uz;
+
+			for (const auto& [coord, column] : column_meshes)
+			{
+				if (column.meshes > 0)
+				{
+					column_culler.add(column.bounds);
+					culled_columns.emplace_back(coord, &column);
+					meshes += column.meshes;
+				}
+			}
+
+			visible.clear();
+			column_culler.cull(frustum, visible);
+
+			subchunk_culler.clear();
+			culled_subchunks.clear();
+
+			for (const auto index : visible)
+			{
+				const auto [coord, column] = culled_columns[index];
+
+				for (auto i = 0uz; i < column->subchunks.size(); i++)
+				{
+					const auto& subchunk = column->subchunks[i];
+
+					if (subchunk.gpu != nullptr)
+					{
+						subchunk_culler.add(subchunk.bounds);
+						culled_subchunks.emplace_back(geo::Chunk::subchunk_coord(coord, i), &subchunk);
+					}
+				}
+			}
+
+			visible.clear();
+			subchunk_culler.cull(frustum, visible);
+
+			drawn = visible.size();
+			culled = meshes - drawn;
+
+			if (drawn > draws->commands.capacity())
+			{
+				const auto capacity = 2 * drawn;
+				draws = std::make_unique<draw_list>(((capacity + draw_list::GRANULARITY - 1) / draw_list::GRANULARITY) * draw_list::GRANULARITY);
+			}
+
+			const auto commands = draws->commands.region();
+			const auto origins = draws->origins.region();
+
+			auto draw_count = 0uz;
+
+			for (const auto index : visible)
+			{
+				const auto [coord, entry] = culled_subchunks[index];
+				const auto origin = subchunk_origin(coord);
+
+				commands[draw_count] = draw_command
+				{
+					static_cast<GLuint>(index_arena.size(entry->gpu->indices)), 1,
+					static_cast<GLuint>(index_arena.offset(entry->gpu->indices)),
+					static_cast<GLint>(vertex_arena.offset(entry->gpu->vertices)), 0,
+				};
+
+				origins[draw_count] = fx::vec4{ origin[0], origin[1], origin[2], 0.0f };
+				draw_count++;
+			}
+
+			world_program.use();
+			world_program.upload_matrix(pv, "world_pv");
+
+			index_arena.attach();
+			draws->commands.attach();
+			draws->origins.base(4);
+
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<void*>(sizeof(draw_command) * draws->commands.first()),
+				static_cast<GLsizei>(draw_count), 0);
+
+			draws->commands.advance();
+			draws->origins.advance();
+		}
 
 
 		sky_m = fx::multiply(fx::translation(camera.pos()), fx::scale(fx::identity(), 1000.0f));
@@ -914,9 +1322,15 @@ int APIENTRY wWinMain(_In_     HINSTANCE instance,
 		sky_program.use();
 		sky_program.upload_matrix(sky_imvp, "sky_imvp");
 
-		sky_vertex_buffer.bind();
+		std::ranges::copy(skybox, sky_vertex_buffer.region().begin());
+
+		glDrawArrays(GL_TRIANGLES, static_cast<GLint>(sky_vertex_buffer.first()), static_cast<GLsizei>(skybox.size()));
+		sky_vertex_buffer.advance();
 
-		glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(skybox.size()));
+		if (gpu_cull)
+		{
+			gpu_culling->present();
+		}
 
 		//glFinish();
 
@@ -0,0 +1,308 @@
+#ifndef GEO_MESH_CACHE_H
+#define GEO_MESH_CACHE_H
+
+#include <bit>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "mesher.h"
+
+namespace geo
+{
+	namespace detail
+	{
+		// two unrelated multiply-xorshift rounds per word, so keys agreeing by chance on one half
+		// still tell apart on the other; cheap enough to run over every voxel
+		struct KeyHasher
+		{
+			std::uint64_t hash = 0xCBF29CE484222325ull;
+			std::uint64_t check = 0x84222325CBF29CE4ull;
+
+			constexpr void mix(const std::uint64_t value)
+			{
+				hash = (hash ^ value) * 0x9E3779B97F4A7C15ull;
+				hash ^= hash >> 29;
+
+				check = std::rotl(check + value, 23) * 0xC2B2AE3D27D4EB4Full;
+				check ^= check >> 31;
+			}
+		};
+
+		// the layer of a neighbor's opaque mask that touches the subchunk across face f
+		template<std::size_t LENGTH>
+		void mix_border(KeyHasher& h, const OccupancyMask<LENGTH>& opaque, const int f)
+		{
+			using Mask = OccupancyMask<LENGTH>;
+
+			constexpr auto L = LENGTH;
+
+			const auto a = face_axis[f];
+			const auto layer = (face_direction[f] > 0) ? 0uz : L - 1;
+
+			switch (a)
+			{
+			case 0:
+				for (auto y = 0uz; y < L; y++)
+				{
+					h.mix(opaque.rows[Mask::row(layer, y)]);
+				}
+
+				break;
+
+			case 1:
+				for (auto x = 0uz; x < L; x++)
+				{
+					h.mix(opaque.rows[Mask::row(x, layer)]);
+				}
+
+				break;
+
+			default:
+				for (auto base = 0uz; base < Mask::ROWS; base += 64)
+				{
+					auto bits = std::uint64_t{ 0 };
+
+					for (auto i = 0uz; i < 64 && base + i < Mask::ROWS; i++)
+					{
+						bits |= static_cast<std::uint64_t>((opaque.rows[base + i] >> layer) & 1) << i;
+					}
+
+					h.mix(bits);
+				}
+
+				break;
+			}
+		}
+	}
+
+	// the content key of a subchunk's mesh. hash picks the slot and check confirms it, so two different
+	// subchunks only share a mesh if both 64-bit halves collide. a hash of 0 means "no key"
+	struct MeshKey
+	{
+		std::uint64_t hash;
+		std::uint64_t check;
+
+		bool operator==(const MeshKey&) const = default;
+	};
+
+	struct MeshKeyHash
+	{
+		std::size_t operator()(const MeshKey& key) const
+		{
+			return static_cast<std::size_t>(key.hash);
+		}
+	};
+
+	// identifies the mesh a subchunk produces: its voxels, the neighbors' opaque border layers and the mode.
+	// vertices are local to the subchunk, so equal keys mean interchangeable meshes wherever they are drawn.
+	// the hash is never 0, which callers can use for "no key"
+	template<typename SubchunkType>
+	MeshKey mesh_key(const SubchunkType& subchunk, const MeshMode mode, const BasicNeighbors<SubchunkType>& neighbors = {})
+	{
+		static constexpr auto L = SubchunkType::CHUNK_LENGTH;
+		static constexpr auto VOLUME = static_cast<std::size_t>(SubchunkType::CHUNK_VOLUME);
+
+		detail::KeyHasher h{};
+		h.mix((static_cast<std::uint64_t>(L) << 8) | static_cast<std::uint64_t>(mode));
+
+		if (subchunk.uniform())
+		{
+			h.mix(0x100000000ull | subchunk.palette().front());
+		}
+
+		else
+		{
+			// four ids per word, in layout order
+			for (auto index = 0uz; index < VOLUME; index += 4)
+			{
+				auto word = std::uint64_t{ 0 };
+
+				for (auto i = 0uz; i < 4 && index + i < VOLUME; i++)
+				{
+					word |= static_cast<std::uint64_t>(subchunk.get(index + i)) << (i * 16);
+				}
+
+				h.mix(word);
+			}
+		}
+
+		const auto& types = registry();
+
+		for (auto f = 0; f < 6; f++)
+		{
+			const auto neighbor = neighbors[f];
+
+			// missing and transparent uniform neighbors cull nothing, so they hash alike
+			if (neighbor == nullptr || neighbor->uniform())
+			{
+				const auto opaque = neighbor != nullptr && types.opaque(neighbor->palette().front());
+				h.mix(opaque ? 0x200000001ull : 0x200000000ull);
+			}
+
+			else
+			{
+				detail::mix_border(h, neighbor->opaque(), f);
+			}
+		}
+
+		return MeshKey{ (h.hash != 0) ? h.hash : 1, h.check };
+	}
+
+	// recently built meshes by content key, so identical subchunks (flat ground, repeated structures, a subchunk
+	// remeshed unchanged) reuse one mesh. bounded by the bytes of mesh data held, evicting the least recently
+	// used; meshes are shared, so an evicted one stays alive for whoever still holds it. safe to share between threads
+	class MeshCache
+	{
+	public:
+		struct Stats
+		{
+			std::size_t hits;
+			std::size_t misses;
+			std::size_t evictions;
+		};
+
+	private:
+		struct Entry
+		{
+			MeshKey key;
+			std::shared_ptr<const Mesh> mesh;
+		};
+
+	private:
+		mutable std::mutex _mutex;
+
+		// most recently used at the front
+		std::list<Entry> _order;
+		std::unordered_map<MeshKey, std::list<Entry>::iterator, MeshKeyHash> _entries;
+
+		std::size_t _capacity;
+		std::size_t _bytes;
+		Stats _stats;
+
+	private:
+		static std::size_t bytes(const Mesh& mesh)
+		{
+			return (mesh.vertices.size() * sizeof(Vertex)) + (mesh.indices.size() * sizeof(GLuint));
+		}
+
+	public:
+		std::shared_ptr<const Mesh> find(const MeshKey& key)
+		{
+			std::scoped_lock lock{ _mutex };
+
+			const auto found = _entries.find(key);
+
+			if (found == _entries.end())
+			{
+				_stats.misses++;
+				return nullptr;
+			}
+
+			_stats.hits++;
+			_order.splice(_order.begin(), _order, found->second);
+
+			return found->second->mesh;
+		}
+
+		void insert(const MeshKey& key, std::shared_ptr<const Mesh> mesh)
+		{
+			std::scoped_lock lock{ _mutex };
+
+			// another thread may have built the same mesh in the meantime
+			if (_entries.contains(key))
+			{
+				return;
+			}
+
+			_bytes += bytes(*mesh);
+			_order.emplace_front(Entry{ key, std::move(mesh) });
+			_entries.emplace(key, _order.begin());
+
+			while (_bytes > _capacity && _order.size() > 1)
+			{
+				_bytes -= bytes(*_order.back().mesh);
+				_entries.erase(_order.back().key);
+				_order.pop_back();
+
+				_stats.evictions++;
+			}
+		}
+
+	public:
+		std::size_t memory() const
+		{
+			std::scoped_lock lock{ _mutex };
+			return _bytes;
+		}
+
+		std::size_t size() const
+		{
+			std::scoped_lock lock{ _mutex };
+			return _entries.size();
+		}
+
+		Stats stats() const
+		{
+			std::scoped_lock lock{ _mutex };
+			return _stats;
+		}
+
+	public:
+		MeshCache(const std::size_t capacity = 16 << 20)
+			: _capacity{ capacity }, _bytes{ 0 }, _stats{}
+		{
+		}
+
+		MeshCache(const MeshCache&) = delete;
+		MeshCache& operator=(const MeshCache&) = delete;
+	};
+
+	// build_mesh through the cache: appends the subchunk's geometry to mesh, reusing a cached copy when the
+	// contents and borders were meshed before. returns the key, or one hashing to 0 for subchunks that produce nothing
+	template<typename SubchunkType>
+	MeshKey build_mesh(MeshCache& cache, const SubchunkType& subchunk, Mesh& mesh, const MeshMode mode, const BasicNeighbors<SubchunkType>& neighbors = {})
+	{
+		if (skippable(subchunk, neighbors))
+		{
+			return MeshKey{};
+		}
+
+		const auto key = mesh_key(subchunk, mode, neighbors);
+		const auto base = static_cast<GLuint>(mesh.vertices.size());
+		const auto first = mesh.indices.size();
+
+		if (const auto cached = cache.find(key))
+		{
+			mesh.reserve(mesh.faces() + cached->faces());
+			mesh.vertices.insert(mesh.vertices.end(), cached->vertices.begin(), cached->vertices.end());
+
+			for (const auto index : cached->indices)
+			{
+				mesh.indices.emplace_back(base + index);
+			}
+
+			return key;
+		}
+
+		build_mesh(subchunk, mesh, mode, neighbors);
+
+		// cache just the appended part, with indices rebased to its first vertex
+		auto built = std::make_shared<Mesh>();
+		built->vertices.assign(mesh.vertices.begin() + base, mesh.vertices.end());
+		built->indices.reserve(mesh.indices.size() - first);
+
+		for (auto i = first; i < mesh.indices.size(); i++)
+		{
+			built->indices.emplace_back(mesh.indices[i] - base);
+		}
+
+		cache.insert(key, std::move(built));
+
+		return key;
+	}
+}
+
+#endif
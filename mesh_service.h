@@ -0,0 +1,266 @@
+#ifndef GEO_MESH_SERVICE_H
+#define GEO_MESH_SERVICE_H
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "mesh_cache.h"
+#include "scheduler.h"
+
+namespace geo
+{
+	// a snapshot of everything a worker needs, so the main thread can keep editing while it runs;
+	// coord is in subchunk units so every subchunk of a column is versioned on its own
+	struct MeshJob
+	{
+		ChunkCoord coord;
+		std::uint64_t version;
+		MeshMode mode;
+		Subchunk subchunk;
+		std::array<std::optional<Subchunk>, 6> neighbors;
+	};
+
+	// key is the mesh's content key when the service meshes through a cache, and hashes to 0 otherwise
+	struct MeshResult
+	{
+		ChunkCoord coord;
+		std::uint64_t version;
+		MeshKey key;
+		Mesh mesh;
+		MeshResult* next;
+	};
+
+	// lock-free multi-producer single-consumer list: workers push with a CAS loop and
+	// the consumer detaches everything finished so far with a single exchange
+	class CompletionQueue
+	{
+	private:
+		std::atomic<MeshResult*> _head;
+
+	public:
+		void push(MeshResult* result)
+		{
+			result->next = _head.load(std::memory_order_relaxed);
+
+			while (!_head.compare_exchange_weak(result->next, result, std::memory_order_release, std::memory_order_relaxed))
+			{
+			}
+		}
+
+		// returns the detached results oldest first
+		MeshResult* take_all()
+		{
+			auto list = _head.exchange(nullptr, std::memory_order_acquire);
+
+			MeshResult* reversed = nullptr;
+
+			while (list != nullptr)
+			{
+				const auto next = list->next;
+				list->next = reversed;
+				reversed = list;
+				list = next;
+			}
+
+			return reversed;
+		}
+
+	public:
+		CompletionQueue()
+			: _head{ nullptr }
+		{
+		}
+
+		~CompletionQueue()
+		{
+			auto list = take_all();
+
+			while (list != nullptr)
+			{
+				const auto next = list->next;
+				delete list;
+				list = next;
+			}
+		}
+	};
+
+	// meshes subchunks as jobs on a Scheduler shared with the rest of the engine, so there is one pool of
+	// worker threads; submit() and poll() belong to one owning thread. pending() counts the jobs in flight,
+	// so other work can run_after() it. block types must all be registered before the first submit, since
+	// workers read the registry unlocked
+	class MeshService
+	{
+	private:
+		// the newest version submitted for a coord, and how many of its jobs are queued, running or undelivered
+		struct Tracked
+		{
+			std::uint64_t latest;
+			std::size_t outstanding;
+		};
+
+	private:
+		Scheduler& _scheduler;
+		Counter _pending;
+
+		std::mutex _mutex;
+		std::unordered_map<ChunkCoord, Tracked, ChunkCoordHash> _tracked;
+
+	private:
+		CompletionQueue _completed;
+		std::atomic<std::size_t> _dropped;
+
+		MeshCache* _cache;
+
+	private:
+		bool stale(const ChunkCoord& coord, const std::uint64_t version) const
+		{
+			const auto tracked = _tracked.find(coord);
+			return tracked != _tracked.end() && tracked->second.latest > version;
+		}
+
+		// a job for coord is done with, delivered or not; coords with nothing left in flight are forgotten
+		void settle(const ChunkCoord& coord)
+		{
+			const auto tracked = _tracked.find(coord);
+
+			if (--tracked->second.outstanding == 0)
+			{
+				_tracked.erase(tracked);
+			}
+		}
+
+		void work(MeshJob& job)
+		{
+			{
+				std::scoped_lock lock{ _mutex };
+
+				// a newer version was submitted after this one, so don't bother meshing it
+				if (stale(job.coord, job.version))
+				{
+					settle(job.coord);
+					_dropped.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+			}
+
+			Neighbors neighbors{};
+
+			for (auto i = 0uz; i < neighbors.size(); i++)
+			{
+				if (job.neighbors[i].has_value())
+				{
+					neighbors[i] = &*job.neighbors[i];
+				}
+			}
+
+			auto result = new MeshResult{ job.coord, job.version, {}, {}, nullptr };
+
+			if (_cache != nullptr)
+			{
+				result->key = build_mesh(*_cache, job.subchunk, result->mesh, job.mode, neighbors);
+			}
+
+			else
+			{
+				build_mesh(job.subchunk, result->mesh, job.mode, neighbors);
+			}
+
+			_completed.push(result);
+		}
+
+	public:
+		void submit(MeshJob job)
+		{
+			{
+				std::scoped_lock lock{ _mutex };
+
+				auto& tracked = _tracked[job.coord];
+				tracked.latest = std::max(tracked.latest, job.version);
+				tracked.outstanding++;
+
+			}
+
+			_scheduler.run([this, job = std::move(job)]() mutable { work(job); }, &_pending);
+		}
+
+		// hands every finished, still-current mesh to callable(MeshResult&) and discards the rest;
+		// returns how many were handed over
+		std::size_t poll(auto callable)
+		{
+			auto list = _completed.take_all();
+
+			if (list == nullptr)
+			{
+				return 0;
+			}
+
+			auto delivered = 0uz;
+
+			std::unique_lock lock{ _mutex };
+
+			while (list != nullptr)
+			{
+				const auto next = list->next;
+				const auto current = !stale(list->coord, list->version);
+
+				settle(list->coord);
+
+				if (!current)
+				{
+					_dropped.fetch_add(1, std::memory_order_relaxed);
+				}
+
+				else
+				{
+					lock.unlock();
+					callable(*list);
+					lock.lock();
+
+					delivered++;
+				}
+
+				delete list;
+				list = next;
+			}
+
+			return delivered;
+		}
+
+	public:
+		std::size_t workers() const
+		{
+			return _scheduler.workers();
+		}
+
+		Counter& pending()
+		{
+			return _pending;
+		}
+
+		// jobs or results thrown away because the chunk was resubmitted in the meantime
+		std::size_t dropped() const
+		{
+			return _dropped.load(std::memory_order_relaxed);
+		}
+
+	public:
+		// meshes go through cache if one is given
+		MeshService(Scheduler& scheduler, MeshCache* cache = nullptr)
+			: _scheduler{ scheduler }, _dropped{ 0 }, _cache{ cache }
+		{
+		}
+
+		// jobs refer to the service, so let them all finish, helping out meanwhile
+		~MeshService()
+		{
+			_scheduler.wait(_pending);
+		}
+
+		MeshService(const MeshService&) = delete;
+		MeshService& operator=(const MeshService&) = delete;
+	};
+}
+
+#endif
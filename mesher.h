@@ -0,0 +1,524 @@
+#ifndef GEO_MESHER_H
+#define GEO_MESHER_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+
+#include "geometry.h"
+#include "block.h"
+#include "chunk.h"
+
+namespace geo
+{
+	enum class MeshMode
+	{
+		NAIVE,
+		GREEDY,
+		BINARY,
+	};
+
+	constexpr std::string_view mesh_mode_name(const MeshMode mode)
+	{
+		switch (mode)
+		{
+		case MeshMode::NAIVE:  return "naive";
+		case MeshMode::GREEDY: return "greedy";
+		case MeshMode::BINARY: return "binary";
+		}
+
+		return "unknown";
+	}
+
+	// axis and direction of each face's outward normal, indexed by Face
+	inline constexpr std::array<int, 6> face_axis{ 2, 1, 0, 0, 2, 1 };
+	inline constexpr std::array<int, 6> face_direction{ 1, 1, -1, 1, -1, -1 };
+
+	// the six subchunks sharing a face with the one being meshed, indexed by Face;
+	// a missing neighbor is treated as air so its border faces stay visible
+	template<typename SubchunkType>
+	using BasicNeighbors = std::array<const SubchunkType*, 6>;
+
+	using Neighbors = BasicNeighbors<Subchunk>;
+
+	constexpr Face face_of(const int axis, const int direction)
+	{
+		switch (axis)
+		{
+		case 0:  return (direction > 0) ? RIGHT_FACE : LEFT_FACE;
+		case 1:  return (direction > 0) ? TOP_FACE : BOTTOM_FACE;
+		default: return (direction > 0) ? CLOSE_FACE : FAR_FACE;
+		}
+	}
+
+	// faces whose neighboring subchunk must be remeshed after an edit at (x, y, z), as a bitmask of 1 << Face
+	template<int LENGTH = Subchunk::CHUNK_LENGTH>
+	constexpr std::uint8_t border_neighbors(const int x, const int y, const int z)
+	{
+		constexpr auto LAST = LENGTH - 1;
+
+		const std::array<int, 3> p{ x, y, z };
+
+		std::uint8_t result = 0;
+
+		for (auto axis = 0; axis < 3; axis++)
+		{
+			if (p[axis] == 0)
+			{
+				result |= 1 << face_of(axis, -1);
+			}
+
+			if (p[axis] == LAST)
+			{
+				result |= 1 << face_of(axis, 1);
+			}
+		}
+
+		return result;
+	}
+
+	namespace detail
+	{
+		// emits one quad covering the blocks lo..hi (inclusive) on the given face;
+		// corners reuse the cube table winding so culling behaves like the per-block faces
+		inline void emit_quad(Mesh& mesh, const Face face, const std::array<int, 3>& lo, const std::array<int, 3>& hi, const BlockId id)
+		{
+			const auto base = static_cast<GLuint>(mesh.vertices.size());
+			const auto& indices = face_indices[face];
+
+			for (const auto corner : { indices[0], indices[1], indices[2], indices[4] })
+			{
+				const auto& unit = cube_vertices[corner];
+
+				std::array<std::uint32_t, 3> pos{};
+
+				for (auto axis = 0; axis < 3; axis++)
+				{
+					pos[axis] = (unit[axis] > 0.0f) ? (hi[axis] + 1) : lo[axis];
+				}
+
+				mesh.vertices.emplace_back(Vertex::pack(pos[0], pos[1], pos[2], face, Vertex::MAX_AO, id));
+			}
+
+			for (const auto i : { 0u, 1u, 2u, 2u, 3u, 0u })
+			{
+				mesh.indices.emplace_back(base + i);
+			}
+		}
+	}
+
+	namespace detail
+	{
+		// the narrowest word holding one bit per block of a LENGTH-long column
+		template<std::size_t LENGTH>
+		using Column = std::conditional_t<(LENGTH <= 32), std::uint32_t, std::uint64_t>;
+
+		// the low count bits, without shifting by the full width of the word
+		template<typename Word>
+		constexpr Word low_bits(const int count)
+		{
+			return (count >= std::numeric_limits<Word>::digits) ? ~Word{ 0 } : ((Word{ 1 } << count) - 1);
+		}
+
+		// working set shared by the meshers; it is far too large for the stack once subchunks grow, so it
+		// comes from the thread's scratch arena and is only valid until the caller's Arena::Scope closes
+		template<std::size_t LENGTH>
+		struct MeshScratch
+		{
+			static_assert(LENGTH <= 64, "a subchunk column must fit in one word");
+			static_assert(LENGTH < (1u << Vertex::POSITION_BITS), "corner coordinates must fit in a packed vertex");
+
+			static constexpr auto L = static_cast<int>(LENGTH);
+
+			using Word = Column<LENGTH>;
+
+			// visible faces of every block, indexed by Face
+			std::array<OccupancyMask<LENGTH>, 6> faces;
+
+			// the palette decoded once so later passes only touch flat memory
+			std::array<BlockId, LENGTH * LENGTH * LENGTH> ids;
+
+			// blocks of the type currently being meshed
+			OccupancyMask<LENGTH> solid;
+
+			std::array<std::array<Word, LENGTH>, LENGTH> planes;
+		};
+
+		template<std::size_t LENGTH>
+		MeshScratch<LENGTH>& mesh_scratch()
+		{
+			return scratch_arena().allocate<MeshScratch<LENGTH>>(1).front();
+		}
+
+		// culls every face of the subchunk against its own and its neighbors' opaque masks in bulk;
+		// a missing neighbor reads as air
+		template<typename SubchunkType>
+		void cull_faces(const SubchunkType& subchunk, const BasicNeighbors<SubchunkType>& neighbors, MeshScratch<SubchunkType::CHUNK_LENGTH>& scratch)
+		{
+			static constexpr auto L = SubchunkType::CHUNK_LENGTH;
+
+			for (auto f = 0; f < 6; f++)
+			{
+				const auto& neighbor = (neighbors[f] == nullptr) ? OccupancyMask<L>::none() : neighbors[f]->opaque();
+				visible_faces(face_axis[f], face_direction[f], subchunk.filled(), subchunk.opaque(), neighbor, scratch.faces[f]);
+			}
+		}
+
+		template<std::size_t LENGTH>
+		std::size_t exposed_faces(const MeshScratch<LENGTH>& scratch)
+		{
+			auto count = 0uz;
+
+			for (const auto& faces : scratch.faces)
+			{
+				count += faces.count();
+			}
+
+			return count;
+		}
+
+		// calls visit(x, y, z) for every set bit of mask
+		template<std::size_t LENGTH, typename Visit>
+		void for_each_voxel(const OccupancyMask<LENGTH>& mask, Visit&& visit)
+		{
+			for (auto x = 0; x < static_cast<int>(LENGTH); x++)
+			{
+				for (auto y = 0; y < static_cast<int>(LENGTH); y++)
+				{
+					auto bits = mask.rows[OccupancyMask<LENGTH>::row(x, y)];
+
+					while (bits != 0)
+					{
+						visit(x, y, std::countr_zero(bits));
+						bits &= bits - 1;
+					}
+				}
+			}
+		}
+	}
+
+	// emits one four-vertex quad per exposed block face
+	template<typename SubchunkType>
+	void mesh_naive(const SubchunkType& subchunk, Mesh& mesh, const BasicNeighbors<SubchunkType>& neighbors = {})
+	{
+		Arena::Scope scope{ scratch_arena() };
+
+		auto& scratch = detail::mesh_scratch<SubchunkType::CHUNK_LENGTH>();
+		detail::cull_faces(subchunk, neighbors, scratch);
+
+		for (auto f = 0; f < 6; f++)
+		{
+			detail::for_each_voxel(scratch.faces[f], [&](const int x, const int y, const int z)
+			{
+				const std::array<int, 3> p{ x, y, z };
+				detail::emit_quad(mesh, static_cast<Face>(f), p, p, subchunk.get(x, y, z));
+			});
+		}
+	}
+
+	// merges coplanar visible faces of the same block type into maximal rectangles
+	template<typename SubchunkType>
+	void mesh_greedy(const SubchunkType& subchunk, Mesh& mesh, const BasicNeighbors<SubchunkType>& neighbors = {})
+	{
+		static constexpr auto L = SubchunkType::CHUNK_LENGTH;
+
+		Arena::Scope scope{ scratch_arena() };
+
+		auto& scratch = detail::mesh_scratch<L>();
+		detail::cull_faces(subchunk, neighbors, scratch);
+
+		std::array<BlockId, L * L> mask{};
+
+		for (auto f = 0; f < 6; f++)
+		{
+			const auto face = static_cast<Face>(f);
+			const auto a = face_axis[f];
+			const auto u = (a + 1) % 3;
+			const auto v = (a + 2) % 3;
+
+			for (auto slice = 0; slice < L; slice++)
+			{
+				// collect the visible faces of this slice
+				for (auto j = 0; j < L; j++)
+				{
+					for (auto i = 0; i < L; i++)
+					{
+						std::array<int, 3> p{};
+						p[a] = slice;
+						p[u] = i;
+						p[v] = j;
+
+						mask[(j * L) + i] = scratch.faces[f].get(p[0], p[1], p[2]) ? subchunk.get(p[0], p[1], p[2]) : AIR;
+					}
+				}
+
+				// then sweep it into rectangles
+				for (auto j = 0; j < L; j++)
+				{
+					for (auto i = 0; i < L; )
+					{
+						const auto id = mask[(j * L) + i];
+
+						if (id == AIR)
+						{
+							i++;
+							continue;
+						}
+
+						auto width = 1;
+
+						while (i + width < L && mask[(j * L) + i + width] == id)
+						{
+							width++;
+						}
+
+						auto height = 1;
+
+						for (; j + height < L; height++)
+						{
+							auto row = true;
+
+							for (auto k = 0; k < width; k++)
+							{
+								if (mask[((j + height) * L) + i + k] != id)
+								{
+									row = false;
+									break;
+								}
+							}
+
+							if (!row)
+							{
+								break;
+							}
+						}
+
+						for (auto h = 0; h < height; h++)
+						{
+							for (auto k = 0; k < width; k++)
+							{
+								mask[((j + h) * L) + i + k] = AIR;
+							}
+						}
+
+						std::array<int, 3> lo{}, hi{};
+						lo[a] = hi[a] = slice;
+						lo[u] = i;
+						hi[u] = i + width - 1;
+						lo[v] = j;
+						hi[v] = j + height - 1;
+
+						detail::emit_quad(mesh, face, lo, hi, id);
+
+						i += width;
+					}
+				}
+			}
+		}
+	}
+
+	// true when a subchunk can't produce any faces without decoding a single voxel: it is all air,
+	// or uniformly opaque and buried between uniformly opaque neighbors
+	template<typename SubchunkType>
+	bool skippable(const SubchunkType& subchunk, const BasicNeighbors<SubchunkType>& neighbors = {})
+	{
+		if (subchunk.empty())
+		{
+			return true;
+		}
+
+		const auto& types = registry();
+
+		const auto buried = [&](const SubchunkType* other)
+		{
+			return other != nullptr && other->uniform() && types.opaque(other->palette().front());
+		};
+
+		return buried(&subchunk) && std::ranges::all_of(neighbors, buried);
+	}
+
+	// exact number of unit faces the naive mesher would emit; an upper bound for the greedy ones
+	template<typename SubchunkType>
+	std::size_t count_faces(const SubchunkType& subchunk, const BasicNeighbors<SubchunkType>& neighbors = {})
+	{
+		if (skippable(subchunk, neighbors))
+		{
+			return 0;
+		}
+
+		Arena::Scope scope{ scratch_arena() };
+
+		auto& scratch = detail::mesh_scratch<SubchunkType::CHUNK_LENGTH>();
+		detail::cull_faces(subchunk, neighbors, scratch);
+		return detail::exposed_faces(scratch);
+	}
+
+	// greedy meshing over bit masks: visible faces come from the bulk occupancy culling, each block type's
+	// share of them is transposed into per-slice planes, and rectangles are grown with bit scans
+	template<typename SubchunkType>
+	void mesh_binary(const SubchunkType& subchunk, Mesh& mesh, const BasicNeighbors<SubchunkType>& neighbors = {})
+	{
+		static constexpr auto L = SubchunkType::CHUNK_LENGTH;
+
+		using Word = typename detail::MeshScratch<L>::Word;
+		using Row = typename OccupancyMask<L>::Row;
+
+		Arena::Scope scope{ scratch_arena() };
+
+		auto& scratch = detail::mesh_scratch<L>();
+		detail::cull_faces(subchunk, neighbors, scratch);
+
+		mesh.reserve(mesh.faces() + detail::exposed_faces(scratch));
+
+		auto& solid = scratch.solid;
+		auto& planes = scratch.planes;
+
+		if (!subchunk.uniform())
+		{
+			for (auto x = 0; x < L; x++)
+			{
+				for (auto y = 0; y < L; y++)
+				{
+					for (auto z = 0; z < L; z++)
+					{
+						scratch.ids[SubchunkType::index(x, y, z)] = subchunk.get(x, y, z);
+					}
+				}
+			}
+		}
+
+		for (const auto id : subchunk.palette())
+		{
+			if (id == AIR)
+			{
+				continue;
+			}
+
+			if (subchunk.uniform())
+			{
+				solid = subchunk.filled();
+			}
+
+			else
+			{
+				auto present = Row{ 0 };
+
+				for (auto x = 0; x < L; x++)
+				{
+					for (auto y = 0; y < L; y++)
+					{
+						auto bits = Row{ 0 };
+
+						for (auto z = 0; z < L; z++)
+						{
+							bits |= static_cast<Row>(static_cast<Row>(scratch.ids[SubchunkType::index(x, y, z)] == id) << z);
+						}
+
+						solid.rows[OccupancyMask<L>::row(x, y)] = bits;
+						present |= bits;
+					}
+				}
+
+				// stale palette entries have no voxels left
+				if (present == 0)
+				{
+					continue;
+				}
+			}
+
+			for (auto f = 0; f < 6; f++)
+			{
+				const auto face = static_cast<Face>(f);
+				const auto a = face_axis[f];
+				const auto u = (a + 1) % 3;
+				const auto v = (a + 2) % 3;
+
+				for (auto& plane : planes)
+				{
+					plane.fill(0);
+				}
+
+				// transpose this type's visible face bits into per-slice (v, u) planes
+				for (auto i = 0uz; i < OccupancyMask<L>::ROWS; i++)
+				{
+					auto faces = static_cast<Row>(scratch.faces[f].rows[i] & solid.rows[i]);
+
+					while (faces != 0)
+					{
+						const std::array<int, 3> p{ static_cast<int>(i / L), static_cast<int>(i % L), std::countr_zero(faces) };
+						planes[p[a]][p[v]] |= Word{ 1 } << p[u];
+						faces &= faces - 1;
+					}
+				}
+
+				for (auto slice = 0; slice < L; slice++)
+				{
+					auto& plane = planes[slice];
+
+					for (auto row = 0; row < L; row++)
+					{
+						while (plane[row] != 0)
+						{
+							const auto start = std::countr_zero(plane[row]);
+							const auto width = std::countr_one(plane[row] >> start);
+							const auto run = static_cast<Word>(detail::low_bits<Word>(width) << start);
+
+							plane[row] &= ~run;
+
+							auto height = 1;
+
+							while (row + height < L && (plane[row + height] & run) == run)
+							{
+								plane[row + height] &= ~run;
+								height++;
+							}
+
+							std::array<int, 3> lo{}, hi{};
+							lo[a] = hi[a] = slice;
+							lo[u] = start;
+							hi[u] = start + width - 1;
+							lo[v] = row;
+							hi[v] = row + height - 1;
+
+							detail::emit_quad(mesh, face, lo, hi, id);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// appends the subchunk's geometry to mesh in a single pass; capacity is reserved up front from the
+	// exposed face count, so a mesh that is cleared and rebuilt stops allocating once it has warmed up
+	template<typename SubchunkType>
+	void build_mesh(const SubchunkType& subchunk, Mesh& mesh, const MeshMode mode, const BasicNeighbors<SubchunkType>& neighbors = {})
+	{
+		if (skippable(subchunk, neighbors))
+		{
+			return;
+		}
+
+		switch (mode)
+		{
+		case MeshMode::NAIVE:
+			mesh.reserve(mesh.faces() + count_faces(subchunk, neighbors));
+			mesh_naive(subchunk, mesh, neighbors);
+			break;
+
+		case MeshMode::GREEDY:
+			mesh.reserve(mesh.faces() + count_faces(subchunk, neighbors));
+			mesh_greedy(subchunk, mesh, neighbors);
+			break;
+
+		case MeshMode::BINARY:
+			mesh_binary(subchunk, mesh, neighbors);
+			break;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef GEO_OCCUPANCY_H
+#define GEO_OCCUPANCY_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GEO_AVX2 1
+#endif
+
+namespace geo
+{
+	namespace detail
+	{
+		// the word holding one row of a LENGTH^3 mask; rows fill their word exactly so shifts never leak between rows
+		template<std::size_t LENGTH>
+		using Row = std::conditional_t<(LENGTH <= 8), std::uint8_t,
+					std::conditional_t<(LENGTH <= 16), std::uint16_t,
+					std::conditional_t<(LENGTH <= 32), std::uint32_t, std::uint64_t>>>;
+	}
+
+	// one bit per voxel of a LENGTH^3 cube, independent of the subchunk's storage layout. bits run along z
+	// inside a row and rows are ordered by x, then y: the neighbor along z is a shift within the row, along
+	// y the next row and along x the next LENGTH rows, so whole-volume neighbor tests are shifts of the array
+	template<std::size_t LENGTH>
+	class OccupancyMask
+	{
+	public:
+		using Row = detail::Row<LENGTH>;
+
+		static_assert(std::numeric_limits<Row>::digits == LENGTH, "occupancy masks need a length of 8, 16, 32 or 64");
+
+		static constexpr auto ROWS = LENGTH * LENGTH;
+
+	public:
+		alignas(32) std::array<Row, ROWS> rows;
+
+	public:
+		static constexpr std::size_t row(std::size_t x, std::size_t y)
+		{
+			return (x * LENGTH) + y;
+		}
+
+		bool get(std::size_t x, std::size_t y, std::size_t z) const
+		{
+			return ((rows[row(x, y)] >> z) & 1) != 0;
+		}
+
+		void set(std::size_t x, std::size_t y, std::size_t z, bool value)
+		{
+			const auto bit = static_cast<Row>(Row{ 1 } << z);
+			auto& word = rows[row(x, y)];
+
+			word = value ? static_cast<Row>(word | bit) : static_cast<Row>(word & ~bit);
+		}
+
+		void fill(bool value)
+		{
+			rows.fill(value ? ~Row{ 0 } : Row{ 0 });
+		}
+
+		std::size_t count() const
+		{
+			auto result = 0uz;
+
+			for (const auto row : rows)
+			{
+				result += std::popcount(row);
+			}
+
+			return result;
+		}
+
+	public:
+		// shared masks for uniform subchunks and missing neighbors
+		static const OccupancyMask& none()
+		{
+			static const auto mask = filled(false);
+			return mask;
+		}
+
+		static const OccupancyMask& all()
+		{
+			static const auto mask = filled(true);
+			return mask;
+		}
+
+	private:
+		static OccupancyMask filled(bool value)
+		{
+			OccupancyMask result;
+			result.fill(value);
+			return result;
+		}
+	};
+
+	// which voxels hold a block, and which of those hide the faces behind them
+	template<std::size_t LENGTH>
+	struct Occupancy
+	{
+		OccupancyMask<LENGTH> filled;
+		OccupancyMask<LENGTH> opaque;
+	};
+
+	namespace detail
+	{
+		// out = filled & ~cover over count rows
+		template<typename Row>
+		void and_not(Row* out, const Row* filled, const Row* cover, std::size_t count)
+		{
+			auto i = 0uz;
+
+#ifdef GEO_AVX2
+			constexpr auto LANES = sizeof(__m256i) / sizeof(Row);
+
+			for (; i < count - (count % LANES); i += LANES)
+			{
+				const auto f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(filled + i));
+				const auto c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cover + i));
+
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_andnot_si256(c, f));
+			}
+#endif
+
+			for (; i < count; i++)
+			{
+				out[i] = static_cast<Row>(filled[i] & ~cover[i]);
+			}
+		}
+
+		// out = filled & ~((opaque >> 1) | (neighbor << (bits - 1))) per row, or mirrored when toward is negative
+		template<typename Row>
+		void and_not_shifted(Row* out, const Row* filled, const Row* opaque, const Row* neighbor, std::size_t count, int toward)
+		{
+			constexpr auto BITS = std::numeric_limits<Row>::digits;
+
+			auto i = 0uz;
+
+#ifdef GEO_AVX2
+			// avx2 has no 8-bit shifts, so the smallest masks stay scalar
+			if constexpr (sizeof(Row) >= 2)
+			{
+				constexpr auto LANES = sizeof(__m256i) / sizeof(Row);
+
+				const auto one = _mm_cvtsi32_si128(1);
+				const auto rest = _mm_cvtsi32_si128(BITS - 1);
+
+				const auto shift_left = [](__m256i v, __m128i count)
+				{
+					if constexpr (sizeof(Row) == 2) return _mm256_sll_epi16(v, count);
+					else if constexpr (sizeof(Row) == 4) return _mm256_sll_epi32(v, count);
+					else return _mm256_sll_epi64(v, count);
+				};
+
+				const auto shift_right = [](__m256i v, __m128i count)
+				{
+					if constexpr (sizeof(Row) == 2) return _mm256_srl_epi16(v, count);
+					else if constexpr (sizeof(Row) == 4) return _mm256_srl_epi32(v, count);
+					else return _mm256_srl_epi64(v, count);
+				};
+
+				for (; i < count - (count % LANES); i += LANES)
+				{
+					const auto f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(filled + i));
+					const auto o = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(opaque + i));
+					const auto n = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(neighbor + i));
+
+					const auto cover = (toward > 0) ? _mm256_or_si256(shift_right(o, one), shift_left(n, rest)) : _mm256_or_si256(shift_left(o, one), shift_right(n, rest));
+
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_andnot_si256(cover, f));
+				}
+			}
+#endif
+
+			for (; i < count; i++)
+			{
+				const auto cover = (toward > 0) ? static_cast<Row>((opaque[i] >> 1) | (neighbor[i] << (BITS - 1))) : static_cast<Row>((opaque[i] << 1) | (neighbor[i] >> (BITS - 1)));
+				out[i] = static_cast<Row>(filled[i] & ~cover);
+			}
+		}
+	}
+
+	// the faces pointing along +-axis of filled voxels that no opaque voxel covers. neighbor is the opaque mask
+	// of the subchunk on that side and supplies the layer just outside the volume. the bulk of the work is one
+	// shifted AND-NOT over the whole array; only the border layer along y needs fixing up row by row
+	template<std::size_t LENGTH>
+	void visible_faces(const int axis, const int direction, const OccupancyMask<LENGTH>& filled, const OccupancyMask<LENGTH>& opaque, const OccupancyMask<LENGTH>& neighbor, OccupancyMask<LENGTH>& out)
+	{
+		using Mask = OccupancyMask<LENGTH>;
+		using Row = typename Mask::Row;
+
+		constexpr auto L = LENGTH;
+		constexpr auto ROWS = Mask::ROWS;
+
+		const auto f = filled.rows.data();
+		const auto o = opaque.rows.data();
+		const auto n = neighbor.rows.data();
+		const auto r = out.rows.data();
+
+		switch (axis)
+		{
+		case 0:
+			if (direction > 0)
+			{
+				detail::and_not(r, f, o + L, ROWS - L);
+				detail::and_not(r + ROWS - L, f + ROWS - L, n, L);
+			}
+
+			else
+			{
+				detail::and_not(r + L, f + L, o, ROWS - L);
+				detail::and_not(r, f, n + ROWS - L, L);
+			}
+
+			break;
+
+		case 1:
+			// rows of one x plane are adjacent, so the last row of each plane reads the next plane's first and is redone
+			if (direction > 0)
+			{
+				detail::and_not(r, f, o + 1, ROWS - 1);
+
+				for (auto x = 0uz; x < L; x++)
+				{
+					const auto last = Mask::row(x, L - 1);
+					r[last] = static_cast<Row>(f[last] & ~n[Mask::row(x, 0)]);
+				}
+			}
+
+			else
+			{
+				detail::and_not(r + 1, f + 1, o, ROWS - 1);
+
+				for (auto x = 0uz; x < L; x++)
+				{
+					const auto first = Mask::row(x, 0);
+					r[first] = static_cast<Row>(f[first] & ~n[Mask::row(x, L - 1)]);
+				}
+			}
+
+			break;
+
+		default:
+			detail::and_not_shifted(r, f, o, n, ROWS, direction);
+			break;
+		}
+	}
+}
+
+#endif
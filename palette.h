@@ -0,0 +1,239 @@
+#ifndef GEO_PALETTE_H
+#define GEO_PALETTE_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <bit>
+#include <algorithm>
+
+#include "allocator.h"
+
+namespace geo
+{
+	using BlockId = std::uint16_t;
+
+	static constexpr BlockId AIR = 0;
+
+	// packs VOLUME block ids as indices into a local palette.
+	// entries are 0/1/2/4/8/16 bits wide so they never straddle a storage word;
+	// a single-entry palette (e.g. all air) needs no voxel storage at all
+	template<std::size_t VOLUME>
+	class PaletteStorage
+	{
+	private:
+		static constexpr auto WORD_BITS = 64;
+
+	private:
+		std::vector<BlockId> _palette;
+		std::vector<std::uint32_t> _counts;
+		std::vector<std::uint64_t> _words;
+		std::size_t _bits;
+
+	private:
+		static constexpr std::size_t width_for(const std::size_t entries)
+		{
+			if (entries <= 1)
+			{
+				return 0;
+			}
+
+			// round up to the next power of two so 64 is always a multiple of the width
+			const auto minimum = std::bit_width(entries - 1);
+			return std::bit_ceil(minimum);
+		}
+
+		static constexpr std::size_t words_for(const std::size_t bits)
+		{
+			return (bits == 0) ? 0 : (VOLUME + (WORD_BITS / bits) - 1) / (WORD_BITS / bits);
+		}
+
+		std::size_t read(const std::size_t index, const std::size_t bits) const
+		{
+			if (bits == 0)
+			{
+				return 0;
+			}
+
+			const auto per_word = WORD_BITS / bits;
+			const auto word = _words[index / per_word];
+			const auto shift = (index % per_word) * bits;
+			const auto mask = (std::uint64_t{ 1 } << bits) - 1;
+
+			return static_cast<std::size_t>((word >> shift) & mask);
+		}
+
+		std::size_t read(const std::size_t index) const
+		{
+			return read(index, _bits);
+		}
+
+		void write(const std::size_t index, const std::size_t entry, const std::size_t bits)
+		{
+			const auto per_word = WORD_BITS / bits;
+			auto& word = _words[index / per_word];
+			const auto shift = (index % per_word) * bits;
+			const auto mask = (std::uint64_t{ 1 } << bits) - 1;
+
+			word = (word & ~(mask << shift)) | (static_cast<std::uint64_t>(entry) << shift);
+		}
+
+		void write(const std::size_t index, const std::size_t entry)
+		{
+			write(index, entry, _bits);
+		}
+
+		// widens in place, so a storage that has been this wide before doesn't allocate. walking down from
+		// the last voxel, each entry's new bits land at or after its old ones and past every entry not yet read
+		void repack(const std::size_t bits)
+		{
+			if (bits == _bits)
+			{
+				return;
+			}
+
+			const auto previous = _bits;
+
+			_words.resize(words_for(bits), 0);
+
+			if (previous == 0)
+			{
+				std::fill(_words.begin(), _words.end(), 0);
+			}
+
+			else
+			{
+				for (auto i = VOLUME; i-- > 0;)
+				{
+					write(i, read(i, previous), bits);
+				}
+			}
+
+			_bits = bits;
+		}
+
+		std::size_t locate(const BlockId id)
+		{
+			const auto existing = std::find(_palette.begin(), _palette.end(), id);
+
+			if (existing != _palette.end())
+			{
+				return std::distance(_palette.begin(), existing);
+			}
+
+			// recycle a slot whose last voxel has since been overwritten
+			const auto unused = std::find(_counts.begin(), _counts.end(), 0);
+
+			if (unused != _counts.end())
+			{
+				const auto entry = std::distance(_counts.begin(), unused);
+				_palette[entry] = id;
+				return entry;
+			}
+
+			_palette.emplace_back(id);
+			_counts.emplace_back(0);
+
+			repack(std::max(_bits, width_for(_palette.size())));
+			return _palette.size() - 1;
+		}
+
+	public:
+		BlockId get(const std::size_t index) const
+		{
+			return _palette[read(index)];
+		}
+
+		void set(const std::size_t index, const BlockId id)
+		{
+			const auto previous = read(index);
+
+			if (_palette[previous] == id)
+			{
+				return;
+			}
+
+			const auto entry = locate(id);
+
+			_counts[previous]--;
+			_counts[entry]++;
+
+			write(index, entry);
+		}
+
+		void fill(const BlockId id)
+		{
+			_palette = { id };
+			_counts = { static_cast<std::uint32_t>(VOLUME) };
+			_words.clear();
+			_bits = 0;
+		}
+
+		// drop unreferenced palette entries and shrink to the narrowest width, in place: walking up from the
+		// first voxel, each entry's new bits land at or before its old ones, behind every entry not yet read
+		void compact()
+		{
+			Arena::Scope scope{ scratch_arena() };
+
+			const auto remap = scratch_arena().allocate<std::uint32_t>(_palette.size());
+
+			auto kept = 0uz;
+
+			for (auto i = 0uz; i < _palette.size(); i++)
+			{
+				remap[i] = static_cast<std::uint32_t>(kept);
+
+				if (_counts[i] != 0)
+				{
+					_palette[kept] = _palette[i];
+					_counts[kept] = _counts[i];
+					kept++;
+				}
+			}
+
+			_palette.resize(kept);
+			_counts.resize(kept);
+
+			const auto previous = _bits;
+			const auto bits = width_for(kept);
+
+			if (bits != 0)
+			{
+				for (auto i = 0uz; i < VOLUME; i++)
+				{
+					write(i, remap[read(i, previous)], bits);
+				}
+			}
+
+			_words.resize(words_for(bits));
+			_bits = bits;
+		}
+
+	public:
+		std::size_t bits() const
+		{
+			return _bits;
+		}
+
+		const std::vector<BlockId>& palette() const
+		{
+			return _palette;
+		}
+
+		// resident bytes of voxel and palette storage, excluding the object itself
+		std::size_t memory() const
+		{
+			return (_words.capacity() * sizeof(std::uint64_t)) +
+				   (_palette.capacity() * sizeof(BlockId)) +
+				   (_counts.capacity() * sizeof(std::uint32_t));
+		}
+
+	public:
+		PaletteStorage()
+			: _palette{ AIR }, _counts{ static_cast<std::uint32_t>(VOLUME) }, _words{}, _bits{ 0 }
+		{
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,512 @@
+#ifndef GEO_SCHEDULER_H
+#define GEO_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace geo
+{
+	// Chase-Lev deque: the owning worker pushes and pops at the bottom,
+	// any other thread may steal from the top
+	template<typename T, std::size_t CAPACITY = 4096>
+	class WorkStealingDeque
+	{
+	private:
+		static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+		static constexpr auto MASK = static_cast<std::int64_t>(CAPACITY - 1);
+
+	private:
+		alignas(64) std::atomic<std::int64_t> _top;
+		alignas(64) std::atomic<std::int64_t> _bottom;
+		std::unique_ptr<std::atomic<T*>[]> _buffer;
+
+	public:
+		// owner only; fails when full so the caller can fall back to another queue
+		bool push(T* item)
+		{
+			const auto b = _bottom.load(std::memory_order_relaxed);
+			const auto t = _top.load(std::memory_order_acquire);
+
+			if (b - t > MASK)
+			{
+				return false;
+			}
+
+			_buffer[b & MASK].store(item, std::memory_order_release);
+			std::atomic_thread_fence(std::memory_order_release);
+			_bottom.store(b + 1, std::memory_order_relaxed);
+
+			return true;
+		}
+
+		// owner only
+		T* pop()
+		{
+			const auto b = _bottom.load(std::memory_order_relaxed) - 1;
+			_bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			auto t = _top.load(std::memory_order_relaxed);
+
+			if (t > b)
+			{
+				_bottom.store(b + 1, std::memory_order_relaxed);
+				return nullptr;
+			}
+
+			auto item = _buffer[b & MASK].load(std::memory_order_relaxed);
+
+			// last item: race any thieves for it
+			if (t == b)
+			{
+				if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+					item = nullptr;
+				}
+
+				_bottom.store(b + 1, std::memory_order_relaxed);
+			}
+
+			return item;
+		}
+
+		// any thread
+		T* steal()
+		{
+			auto t = _top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const auto b = _bottom.load(std::memory_order_acquire);
+
+			if (t >= b)
+			{
+				return nullptr;
+			}
+
+			const auto item = _buffer[t & MASK].load(std::memory_order_acquire);
+
+			if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return nullptr;
+			}
+
+			return item;
+		}
+
+	public:
+		WorkStealingDeque()
+			: _top{ 0 }, _bottom{ 0 }, _buffer{ std::make_unique<std::atomic<T*>[]>(CAPACITY) }
+		{
+		}
+	};
+
+	class Scheduler;
+	struct Job;
+
+	// tracks outstanding jobs; jobs queued with run_after() start once it drops to zero
+	class Counter
+	{
+	private:
+		friend class Scheduler;
+
+	private:
+		std::atomic<std::int64_t> _value;
+		std::mutex _mutex;
+		std::vector<Job*> _continuations;
+
+	public:
+		// once this returns true the counter can be destroyed: the last finishing job
+		// releases the mutex as its final touch, and this takes it before answering
+		bool done()
+		{
+			if (_value.load(std::memory_order_acquire) != 0)
+			{
+				return false;
+			}
+
+			std::scoped_lock lock{ _mutex };
+			return _value.load(std::memory_order_relaxed) == 0;
+		}
+
+	public:
+		Counter()
+			: _value{ 0 }
+		{
+		}
+	};
+
+	struct Job
+	{
+		std::function<void()> work;
+		Counter* counter;
+	};
+
+	// work-stealing job system with one deque per worker. waiting on a counter never parks a core:
+	// the waiting thread keeps executing other jobs until the counter reaches zero
+	class Scheduler
+	{
+	private:
+		struct Worker
+		{
+			WorkStealingDeque<Job> deque;
+			std::atomic<std::size_t> executed;
+			std::atomic<std::size_t> stolen;
+		};
+
+	public:
+		struct Stats
+		{
+			std::size_t executed;
+			std::size_t stolen;
+			std::size_t injected;
+		};
+
+	private:
+		std::vector<std::unique_ptr<Worker>> _workers;
+		std::vector<std::thread> _threads;
+
+	private:
+		// submissions from threads that are not workers of this scheduler
+		std::mutex _injection_mutex;
+		std::deque<Job*> _injection;
+		std::atomic<std::size_t> _injected;
+
+	private:
+		// run_after() jobs parked on counters that have not drained yet, freed on destruction if they never run
+		std::mutex _parked_mutex;
+		std::unordered_set<Job*> _parked;
+
+	private:
+		std::mutex _sleep_mutex;
+		std::condition_variable _wake;
+		std::atomic<std::uint64_t> _epoch;
+		std::atomic<std::size_t> _sleeping;
+		std::atomic<bool> _stopping;
+
+	private:
+		static inline thread_local Scheduler* _current = nullptr;
+		static inline thread_local std::size_t _index = 0;
+
+	private:
+		Worker* local()
+		{
+			return (_current == this) ? _workers[_index].get() : nullptr;
+		}
+
+		void signal()
+		{
+			_epoch.fetch_add(1, std::memory_order_seq_cst);
+
+			if (_sleeping.load(std::memory_order_seq_cst) != 0)
+			{
+				{
+					std::scoped_lock lock{ _sleep_mutex };
+				}
+
+				_wake.notify_one();
+			}
+		}
+
+		void enqueue(Job* job)
+		{
+			const auto worker = local();
+
+			if (worker == nullptr || !worker->deque.push(job))
+			{
+				std::scoped_lock lock{ _injection_mutex };
+				_injection.emplace_back(job);
+				_injected.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			signal();
+		}
+
+		Job* find()
+		{
+			const auto worker = local();
+
+			if (worker != nullptr)
+			{
+				if (const auto job = worker->deque.pop())
+				{
+					return job;
+				}
+			}
+
+			{
+				std::scoped_lock lock{ _injection_mutex };
+
+				if (!_injection.empty())
+				{
+					const auto job = _injection.front();
+					_injection.pop_front();
+					return job;
+				}
+			}
+
+			// start from a different victim on every thread so thieves spread out
+			const auto count = _workers.size();
+			const auto start = (worker != nullptr) ? _index + 1 : std::hash<std::thread::id>{}(std::this_thread::get_id());
+
+			for (auto i = 0uz; i < count; i++)
+			{
+				const auto victim = (start + i) % count;
+
+				if (worker != nullptr && victim == _index)
+				{
+					continue;
+				}
+
+				if (const auto job = _workers[victim]->deque.steal())
+				{
+					if (worker != nullptr)
+					{
+						worker->stolen.fetch_add(1, std::memory_order_relaxed);
+					}
+
+					return job;
+				}
+			}
+
+			return nullptr;
+		}
+
+		void finish(Counter& counter)
+		{
+			std::vector<Job*> continuations{};
+
+			{
+				std::scoped_lock lock{ counter._mutex };
+
+				if (counter._value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					continuations.swap(counter._continuations);
+				}
+			}
+
+			if (!continuations.empty())
+			{
+				std::scoped_lock lock{ _parked_mutex };
+
+				for (const auto job : continuations)
+				{
+					_parked.erase(job);
+				}
+			}
+
+			for (const auto job : continuations)
+			{
+				enqueue(job);
+			}
+		}
+
+		void execute(Job* job)
+		{
+			job->work();
+
+			if (const auto worker = local())
+			{
+				worker->executed.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			if (job->counter != nullptr)
+			{
+				finish(*job->counter);
+			}
+
+			delete job;
+		}
+
+		void work(const std::size_t index)
+		{
+			_current = this;
+			_index = index;
+
+			auto spins = 0;
+
+			while (!_stopping.load(std::memory_order_acquire))
+			{
+				const auto seen = _epoch.load(std::memory_order_seq_cst);
+
+				if (const auto job = find())
+				{
+					execute(job);
+					spins = 0;
+					continue;
+				}
+
+				if (++spins < 64)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				std::unique_lock lock{ _sleep_mutex };
+
+				_sleeping.fetch_add(1, std::memory_order_seq_cst);
+				_wake.wait(lock, [&]()
+				{
+					return _stopping.load(std::memory_order_acquire) || _epoch.load(std::memory_order_seq_cst) != seen;
+				});
+				_sleeping.fetch_sub(1, std::memory_order_seq_cst);
+
+				spins = 0;
+			}
+		}
+
+	public:
+		void run(std::function<void()> work, Counter* counter = nullptr)
+		{
+			if (counter != nullptr)
+			{
+				counter->_value.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			enqueue(new Job{ std::move(work), counter });
+		}
+
+		// starts work once dependency reaches zero, or right away if it already has
+		void run_after(Counter& dependency, std::function<void()> work, Counter* counter = nullptr)
+		{
+			if (counter != nullptr)
+			{
+				counter->_value.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			const auto job = new Job{ std::move(work), counter };
+
+			{
+				std::scoped_lock lock{ dependency._mutex };
+
+				if (dependency._value.load(std::memory_order_acquire) != 0)
+				{
+					{
+						std::scoped_lock parked_lock{ _parked_mutex };
+						_parked.insert(job);
+					}
+
+					dependency._continuations.emplace_back(job);
+					return;
+				}
+			}
+
+			enqueue(job);
+		}
+
+		// helps execute jobs, including unrelated ones, until counter reaches zero
+		void wait(Counter& counter)
+		{
+			while (!counter.done())
+			{
+				if (const auto job = find())
+				{
+					execute(job);
+				}
+
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		// splits [0, count) into chunks of at most grain and runs callable(begin, end) on each
+		void parallel_for(std::size_t count, std::size_t grain, auto callable)
+		{
+			Counter counter{};
+
+			grain = std::max(grain, 1uz);
+
+			for (auto begin = 0uz; begin < count; begin += grain)
+			{
+				const auto end = std::min(begin + grain, count);
+				run([=]() { callable(begin, end); }, &counter);
+			}
+
+			wait(counter);
+		}
+
+	public:
+		std::size_t workers() const
+		{
+			return _workers.size();
+		}
+
+		Stats stats() const
+		{
+			Stats result{ 0, 0, _injected.load(std::memory_order_relaxed) };
+
+			for (const auto& worker : _workers)
+			{
+				result.executed += worker->executed.load(std::memory_order_relaxed);
+				result.stolen += worker->stolen.load(std::memory_order_relaxed);
+			}
+
+			return result;
+		}
+
+	public:
+		// defaults to one worker per hardware thread
+		Scheduler(std::size_t threads = 0)
+			: _injected{ 0 }, _epoch{ 0 }, _sleeping{ 0 }, _stopping{ false }
+		{
+			if (threads == 0)
+			{
+				threads = std::max(1u, std::thread::hardware_concurrency());
+			}
+
+			for (auto i = 0uz; i < threads; i++)
+			{
+				_workers.emplace_back(std::make_unique<Worker>());
+			}
+
+			for (auto i = 0uz; i < threads; i++)
+			{
+				_threads.emplace_back([this, i]() { work(i); });
+			}
+		}
+
+		~Scheduler()
+		{
+			{
+				std::scoped_lock lock{ _sleep_mutex };
+				_stopping.store(true, std::memory_order_release);
+			}
+
+			_wake.notify_all();
+
+			for (auto& thread : _threads)
+			{
+				thread.join();
+			}
+
+			// anything still queued never ran
+			for (const auto job : _injection)
+			{
+				delete job;
+			}
+
+			for (auto& worker : _workers)
+			{
+				while (const auto job = worker->deque.pop())
+				{
+					delete job;
+				}
+			}
+
+			// nor did anything waiting on a counter that never reached zero
+			for (const auto job : _parked)
+			{
+				delete job;
+			}
+		}
+	};
+}
+
+#endif
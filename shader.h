@@ -98,13 +98,30 @@ namespace geo
 			glUniformMatrix4fv(matrix_id, 1, GL_FALSE, &matrix[0][0]);
 		}
 
+		void upload_integer(const GLint value, const std::string& identifier)
+		{
+			auto integer_id = locate_uniform(identifier);
+			glUniform1i(integer_id, value);
+		}
+
 	public:
 		ShaderProgram(const std::string& partial_filepath)
 			: _program_id{ glCreateProgram() }
 		{
 			ShaderFactory factory{ _program_id };
-			factory.compile_shader(GL_VERTEX_SHADER, partial_filepath + ".vertex.glsl");
-			factory.compile_shader(GL_FRAGMENT_SHADER, partial_filepath + ".fragment.glsl");
+
+			// a compute shader makes a program on its own; anything else is a vertex and fragment pair
+			if (std::filesystem::exists(partial_filepath + ".compute.glsl"))
+			{
+				factory.compile_shader(GL_COMPUTE_SHADER, partial_filepath + ".compute.glsl");
+			}
+
+			else
+			{
+				factory.compile_shader(GL_VERTEX_SHADER, partial_filepath + ".vertex.glsl");
+				factory.compile_shader(GL_FRAGMENT_SHADER, partial_filepath + ".fragment.glsl");
+			}
+
 			factory.link();
 		}
 
@@ -2,11 +2,7 @@
 
 in vec3 col;
 in vec3 normal;
-
-layout (std430, binding = 2) buffer Buffer 
-{
-	uint normals[];
-};
+flat in uint face;
 
 
 out vec4 frag_color;
@@ -30,7 +26,7 @@ vec3[] normal_lookup = vec3[]
 void main()
 {
 	const vec3 sun = vec3(1.0, 1.0, 1.0);
-	const vec3 normal = normal_lookup[normals[gl_PrimitiveID / 2]];
+	const vec3 normal = normal_lookup[face];
 
 	float intensity = (dot(normal, sun) + 1.0) / 2.0;
 
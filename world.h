@@ -0,0 +1,414 @@
+#ifndef GEO_WORLD_H
+#define GEO_WORLD_H
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "allocator.h"
+#include "chunk.h"
+#include "mesher.h"
+
+namespace geo
+{
+	// chunks come from fixed-size blocks, so chunk pointers stay valid and unloaded chunks get reused
+	using ChunkPool = Pool<Chunk>;
+
+	// the loaded part of a sparse, unbounded world: chunk coordinates map to chunks through an
+	// open-addressing table with linear probing. loaded chunks are also kept in a dense array,
+	// so visiting every chunk walks contiguous memory instead of the sparse table.
+	// edits made through set(), clear() and fill() record which subchunks need remeshing
+	class World
+	{
+	public:
+		struct Entry
+		{
+			ChunkCoord coord;
+			Chunk* chunk;
+		};
+
+		// a world-space block position split into its subchunk, in subchunk units, and the offset inside it
+		struct BlockAddress
+		{
+			ChunkCoord subchunk;
+			std::array<int, 3> local;
+		};
+
+	private:
+		static constexpr auto EMPTY = ~std::uint32_t{ 0 };
+		static constexpr auto MIN_SLOTS = 64uz;
+
+		struct Slot
+		{
+			ChunkCoord coord;
+			std::uint32_t entry;
+		};
+
+	private:
+		std::vector<Slot> _slots;
+		std::vector<Entry> _entries;
+		ChunkPool _pool;
+
+	private:
+		// subchunk coords in the order they were first marked, and the same set for deduplication
+		std::vector<ChunkCoord> _dirty;
+		std::unordered_set<ChunkCoord, ChunkCoordHash> _marked;
+
+	private:
+		std::size_t mask() const
+		{
+			return _slots.size() - 1;
+		}
+
+		// the slot holding coord, or the empty slot that ends its probe sequence
+		std::size_t probe(const ChunkCoord& coord) const
+		{
+			auto slot = static_cast<std::size_t>(hash(coord)) & mask();
+
+			while (_slots[slot].entry != EMPTY && _slots[slot].coord != coord)
+			{
+				slot = (slot + 1) & mask();
+			}
+
+			return slot;
+		}
+
+		void rehash(std::size_t count)
+		{
+			_slots.assign(count, Slot{ {}, EMPTY });
+
+			for (auto i = 0uz; i < _entries.size(); i++)
+			{
+				_slots[probe(_entries[i].coord)] = Slot{ _entries[i].coord, static_cast<std::uint32_t>(i) };
+			}
+		}
+
+		// backward-shift deletion: pull later members of the cluster into the hole so probes never need tombstones
+		void vacate(std::size_t hole)
+		{
+			auto slot = hole;
+
+			while (true)
+			{
+				slot = (slot + 1) & mask();
+
+				if (_slots[slot].entry == EMPTY)
+				{
+					break;
+				}
+
+				const auto home = static_cast<std::size_t>(hash(_slots[slot].coord)) & mask();
+
+				// only move entries whose home lies cyclically at or before the hole
+				if (((slot - home) & mask()) >= ((slot - hole) & mask()))
+				{
+					_slots[hole] = _slots[slot];
+					hole = slot;
+				}
+			}
+
+			_slots[hole].entry = EMPTY;
+		}
+
+	public:
+		Chunk* find(const ChunkCoord& coord)
+		{
+			const auto& slot = _slots[probe(coord)];
+			return (slot.entry != EMPTY) ? _entries[slot.entry].chunk : nullptr;
+		}
+
+		const Chunk* find(const ChunkCoord& coord) const
+		{
+			const auto& slot = _slots[probe(coord)];
+			return (slot.entry != EMPTY) ? _entries[slot.entry].chunk : nullptr;
+		}
+
+		// returns the chunk at coord, creating an empty one if it isn't loaded yet
+		Chunk& load(const ChunkCoord& coord)
+		{
+			auto slot = probe(coord);
+
+			if (_slots[slot].entry != EMPTY)
+			{
+				return *_entries[_slots[slot].entry].chunk;
+			}
+
+			// keep the load factor at or below 3/4
+			if ((_entries.size() + 1) * 4 > _slots.size() * 3)
+			{
+				rehash(_slots.size() * 2);
+				slot = probe(coord);
+			}
+
+			_slots[slot] = Slot{ coord, static_cast<std::uint32_t>(_entries.size()) };
+			return *_entries.emplace_back(Entry{ coord, _pool.acquire() }).chunk;
+		}
+
+		bool unload(const ChunkCoord& coord)
+		{
+			const auto slot = probe(coord);
+			const auto index = _slots[slot].entry;
+
+			if (index == EMPTY)
+			{
+				return false;
+			}
+
+			*_entries[index].chunk = Chunk{};
+			_pool.release(_entries[index].chunk);
+			vacate(slot);
+
+			// move the last entry into the gap to keep the array dense
+			if (index != _entries.size() - 1)
+			{
+				_entries[index] = _entries.back();
+				_slots[probe(_entries[index].coord)].entry = index;
+			}
+
+			_entries.pop_back();
+			return true;
+		}
+
+	public:
+		static constexpr BlockAddress locate(const int x, const int y, const int z)
+		{
+			constexpr auto L = Subchunk::CHUNK_LENGTH;
+
+			return BlockAddress
+			{
+				ChunkCoord{ floor_div(x, L), floor_div(y, L), floor_div(z, L) },
+				std::array<int, 3>{ floor_mod(x, L), floor_mod(y, L), floor_mod(z, L) },
+			};
+		}
+
+		// the subchunk at coord, in subchunk units, if its column is loaded
+		Subchunk* subchunk(const ChunkCoord& coord)
+		{
+			const auto chunk = find(Chunk::column_coord(coord));
+			return (chunk != nullptr) ? &(*chunk)[Chunk::subchunk_index(coord)] : nullptr;
+		}
+
+		const Subchunk* subchunk(const ChunkCoord& coord) const
+		{
+			const auto chunk = find(Chunk::column_coord(coord));
+			return (chunk != nullptr) ? &(*chunk)[Chunk::subchunk_index(coord)] : nullptr;
+		}
+
+		// air wherever nothing is loaded
+		BlockId get(const int x, const int y, const int z) const
+		{
+			const auto [coord, p] = locate(x, y, z);
+			const auto subchunk = this->subchunk(coord);
+
+			return (subchunk != nullptr) ? subchunk->get(p[0], p[1], p[2]) : AIR;
+		}
+
+		// loads the column if needed; returns whether the block changed. the subchunk is marked dirty,
+		// along with the neighbors that share the border when the block sits on one
+		bool set(const int x, const int y, const int z, const BlockId id)
+		{
+			const auto [coord, p] = locate(x, y, z);
+			auto& subchunk = load(Chunk::column_coord(coord))[Chunk::subchunk_index(coord)];
+
+			if (subchunk.get(p[0], p[1], p[2]) == id)
+			{
+				return false;
+			}
+
+			subchunk.set(p[0], p[1], p[2], id);
+			mark_dirty(coord, border_neighbors(p[0], p[1], p[2]));
+
+			return true;
+		}
+
+		bool clear(const int x, const int y, const int z)
+		{
+			return set(x, y, z, AIR);
+		}
+
+		// sets every block of the inclusive box min..max. subchunks the box covers entirely become uniform
+		// without touching their voxels, and partially covered ones are compacted afterwards
+		void fill(const std::array<int, 3>& min, const std::array<int, 3>& max, const BlockId id)
+		{
+			constexpr auto L = Subchunk::CHUNK_LENGTH;
+
+			if (min[0] > max[0] || min[1] > max[1] || min[2] > max[2])
+			{
+				return;
+			}
+
+			const auto first = locate(min[0], min[1], min[2]).subchunk;
+			const auto last = locate(max[0], max[1], max[2]).subchunk;
+
+			for (auto sx = first.x; sx <= last.x; sx++)
+			{
+				for (auto sy = first.y; sy <= last.y; sy++)
+				{
+					for (auto sz = first.z; sz <= last.z; sz++)
+					{
+						const auto coord = ChunkCoord{ sx, sy, sz };
+						const std::array<int, 3> base{ sx * L, sy * L, sz * L };
+
+						// the part of the box inside this subchunk, in local coordinates
+						std::array<int, 3> from{}, to{};
+						std::uint8_t faces = 0;
+
+						for (auto a = 0; a < 3; a++)
+						{
+							from[a] = std::max(min[a] - base[a], 0);
+							to[a] = std::min(max[a] - base[a], L - 1);
+
+							faces |= (from[a] == 0) ? (1 << face_of(a, -1)) : 0;
+							faces |= (to[a] == L - 1) ? (1 << face_of(a, 1)) : 0;
+						}
+
+						auto& subchunk = load(Chunk::column_coord(coord))[Chunk::subchunk_index(coord)];
+
+						if (faces == 0x3F)
+						{
+							subchunk.fill(id);
+						}
+
+						else
+						{
+							for (auto x = from[0]; x <= to[0]; x++)
+							{
+								for (auto y = from[1]; y <= to[1]; y++)
+								{
+									for (auto z = from[2]; z <= to[2]; z++)
+									{
+										subchunk.set(x, y, z, id);
+									}
+								}
+							}
+
+							subchunk.compact();
+						}
+
+						mark_dirty(coord, faces);
+					}
+				}
+			}
+		}
+
+	public:
+		// queues the subchunk at coord, in subchunk units, for remeshing, plus its loaded neighbors
+		// on the faces set in the 1 << Face bitmask
+		void mark_dirty(const ChunkCoord& coord, const std::uint8_t faces = 0)
+		{
+			if (_marked.insert(coord).second)
+			{
+				_dirty.emplace_back(coord);
+			}
+
+			for (auto f = 0; f < 6; f++)
+			{
+				const auto neighbor = adjacent(coord, static_cast<Face>(f));
+
+				if ((faces & (1 << f)) != 0 && subchunk(neighbor) != nullptr && _marked.insert(neighbor).second)
+				{
+					_dirty.emplace_back(neighbor);
+				}
+			}
+		}
+
+		// hands over every subchunk marked since the last call, in the order they were marked;
+		// some may have been unloaded since
+		std::vector<ChunkCoord> take_dirty()
+		{
+			_marked.clear();
+			return std::exchange(_dirty, {});
+		}
+
+		std::size_t dirty() const
+		{
+			return _dirty.size();
+		}
+
+	public:
+		static constexpr ChunkCoord adjacent(const ChunkCoord& coord, const Face face)
+		{
+			std::array<int, 3> p{ coord.x, coord.y, coord.z };
+			p[face_axis[face]] += face_direction[face];
+
+			return ChunkCoord{ p[0], p[1], p[2] };
+		}
+
+		// the loaded chunks sharing a face with coord, indexed by Face
+		std::array<Chunk*, 6> neighbors(const ChunkCoord& coord)
+		{
+			std::array<Chunk*, 6> result{};
+
+			for (auto f = 0; f < 6; f++)
+			{
+				result[f] = find(adjacent(coord, static_cast<Face>(f)));
+			}
+
+			return result;
+		}
+
+		// what the mesher needs to cull the borders of subchunk index of the chunk at coord;
+		// vertical neighbors come from the same column where there is one
+		Neighbors neighbors(const ChunkCoord& coord, const std::size_t index) const
+		{
+			constexpr auto HEIGHT = static_cast<std::size_t>(Chunk::CHUNK_HEIGHT);
+
+			Neighbors result{};
+
+			for (auto f = 0; f < 6; f++)
+			{
+				const auto face = static_cast<Face>(f);
+
+				if (face == TOP_FACE && index + 1 < HEIGHT)
+				{
+					result[f] = &(*find(coord))[index + 1];
+				}
+
+				else if (face == BOTTOM_FACE && index > 0)
+				{
+					result[f] = &(*find(coord))[index - 1];
+				}
+
+				else if (const auto chunk = find(adjacent(coord, face)))
+				{
+					const auto other = (face == TOP_FACE) ? 0uz : (face == BOTTOM_FACE) ? HEIGHT - 1 : index;
+					result[f] = &(*chunk)[other];
+				}
+			}
+
+			return result;
+		}
+
+	public:
+		auto begin() const
+		{
+			return _entries.begin();
+		}
+
+		auto end() const
+		{
+			return _entries.end();
+		}
+
+		std::size_t size() const
+		{
+			return _entries.size();
+		}
+
+		const ChunkPool& pool() const
+		{
+			return _pool;
+		}
+
+	public:
+		World()
+		{
+			_slots.assign(MIN_SLOTS, Slot{ {}, EMPTY });
+		}
+	};
+}
+
+#endif
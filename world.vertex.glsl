@@ -1,12 +1,35 @@
 #version 460 core
 
-layout (location = 0) in vec4 pos_in;
-layout (location = 1) in vec3 col_in;
+uniform mat4 world_pv;
+
+// see geo::Vertex for the bit layout
+layout (location = 0) in uint packed_lo;
+layout (location = 1) in uint packed_hi;
+
+layout (std430, binding = 3) buffer Colors
+{
+	vec4 colors[];
+};
+
+// where each subchunk of the multi-draw sits, indexed by draw
+layout (std430, binding = 4) buffer Origins
+{
+	vec4 origins[];
+};
 
 out vec3 col;
+flat out uint face;
 
 void main()
 {
-	gl_Position = pos_in;
-	col = col_in;
+	const uvec3 corner = uvec3(packed_lo, packed_lo >> 7, packed_lo >> 14) & 0x7Fu;
+	const float ao = float((packed_lo >> 24) & 0x3u) / 3.0;
+	const uint id = packed_hi & 0xFFFFu;
+
+	// blocks are two units wide and centered on even coordinates
+	const vec3 pos = origins[gl_DrawID].xyz + (vec3(corner) * 2.0) - 1.0;
+
+	gl_Position = world_pv * vec4(pos, 1.0);
+	col = colors[id].rgb * mix(0.5, 1.0, ao);
+	face = (packed_lo >> 21) & 0x7u;
 }
\ No newline at end of file